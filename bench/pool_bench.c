@@ -0,0 +1,180 @@
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_pool.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+/*
+Task pool scaling benchmark.
+
+Ordered-dithers a synthetic frame split into blocks, once per worker count from 1 up to the
+logical processor count, and prints the speedup over a single worker.
+- Flat: every block is submitted from outside the pool, through the injection queue.
+- Nested: a root task splits the frame in halves down to the blocks, so tasks are spawned from
+  inside the pool and spread by stealing.
+
+Usage: pool_bench [--pin]
+*/
+
+#define BENCH_WDTH 1920
+#define BENCH_LN 1080
+#define BENCH_BLOCKS 512 // Power of two, for the nested split.
+#define BENCH_PASSES 8   // Frames per timed run.
+#define BENCH_RUNS 5     // Best of.
+
+typedef struct bench_ctx {
+    uint8_t      *src;
+    uint8_t      *dst;
+    size_t        block_bsize;
+    atomic_size_t remaining;
+    HANDLE        done_ev;
+} bench_ctx;
+
+typedef struct bench_task bench_task;
+
+typedef struct bench_task {
+    pool_task   task;
+    bench_ctx  *ctx;
+    task_pool  *pool;
+    bench_task *tree; // Every task, indexed by `node`.
+    size_t      node; // Heap index, leaves start at `BENCH_BLOCKS`.
+} bench_task;
+
+static const uint8_t bayer4[16] = {
+    0, 128, 32, 160, 192, 64, 224, 96, 48, 176, 16, 144, 240, 112, 208, 80
+};
+
+static void dither_block(
+    bench_ctx   *ctx,
+    const size_t block
+) {
+    const size_t start = block * ctx->block_bsize;
+    for (size_t i = start; i < start + ctx->block_bsize; ++i) {
+        const size_t x = i % BENCH_WDTH;
+        const size_t y = i / BENCH_WDTH;
+        ctx->dst[i] = ctx->src[i] > bayer4[(y % 4) * 4 + x % 4] ? 255 : 0;
+    }
+    const size_t left = atomic_fetch_sub_explicit(&ctx->remaining, 1, memory_order_acq_rel);
+    if (left == 1) {
+        SetEvent(ctx->done_ev);
+    }
+}
+
+static void flat_task(
+    pool_task   *task,
+    const size_t worker
+) {
+    bench_task *bt = (bench_task *)task->arg;
+    dither_block(bt->ctx, bt->node - BENCH_BLOCKS);
+}
+
+static void nested_task(
+    pool_task   *task,
+    const size_t worker
+) {
+    bench_task *bt = (bench_task *)task->arg;
+    if (bt->node >= BENCH_BLOCKS) {
+        dither_block(bt->ctx, bt->node - BENCH_BLOCKS);
+        return;
+    }
+    pool_submit(bt->pool, &bt->tree[bt->node * 2 + 1].task);
+    pool_submit(bt->pool, &bt->tree[bt->node * 2].task);
+}
+
+/// @brief Times `BENCH_PASSES` frames, best of `BENCH_RUNS`.
+/// @return Milliseconds per frame.
+static double run(
+    task_pool  *pool,
+    bench_ctx  *ctx,
+    bench_task *tasks,
+    const bool  nested
+) {
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    double best = DBL_MAX;
+    for (size_t r = 0; r < BENCH_RUNS; ++r) {
+        LARGE_INTEGER start;
+        LARGE_INTEGER end;
+        QueryPerformanceCounter(&start);
+        for (size_t p = 0; p < BENCH_PASSES; ++p) {
+            atomic_store_explicit(&ctx->remaining, BENCH_BLOCKS, memory_order_relaxed);
+            for (size_t i = 1; i < BENCH_BLOCKS * 2; ++i) {
+                tasks[i].task.fn = nested ? nested_task : flat_task;
+                tasks[i].task.arg = &tasks[i];
+                tasks[i].ctx = ctx;
+                tasks[i].pool = pool;
+                tasks[i].tree = tasks;
+                tasks[i].node = i;
+            }
+            if (nested) {
+                pool_submit(pool, &tasks[1].task);
+            } else {
+                for (size_t i = BENCH_BLOCKS; i < BENCH_BLOCKS * 2; ++i) {
+                    pool_submit(pool, &tasks[i].task);
+                }
+            }
+            WaitForSingleObject(ctx->done_ev, INFINITE);
+        }
+        QueryPerformanceCounter(&end);
+        const double ms =
+            (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart / BENCH_PASSES;
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+int main(
+    int    argc,
+    char **argv
+) {
+    tl_result   excv = TL_SUCCESS;
+    const bool  pin = argc > 1 && strcmp(argv[1], "--pin") == 0;
+    bench_ctx   ctx = {.src = NULL, .dst = NULL, .block_bsize = 0, .done_ev = NULL};
+    bench_task *tasks = NULL;
+    task_pool  *pool = NULL;
+    SYSTEM_INFO sys_info;
+    GetSystemInfo(&sys_info);
+    const size_t cpus = sys_info.dwNumberOfProcessors > 0 ? sys_info.dwNumberOfProcessors : 1;
+
+    ctx.src = malloc(BENCH_WDTH * BENCH_LN);
+    ctx.dst = malloc(BENCH_WDTH * BENCH_LN);
+    ctx.block_bsize = BENCH_WDTH * BENCH_LN / BENCH_BLOCKS;
+    ctx.done_ev = CreateEventW(NULL, false, false, NULL);
+    tasks = calloc(BENCH_BLOCKS * 2, sizeof(bench_task));
+    CHECK(excv, ctx.src == NULL || ctx.dst == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    CHECK(excv, tasks == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    CHECK(excv, ctx.done_ev == NULL, TL_OS_ERR, goto epilogue);
+    for (size_t i = 0; i < BENCH_WDTH * BENCH_LN; ++i) {
+        ctx.src[i] = (uint8_t)((i % BENCH_WDTH) * 255 / BENCH_WDTH);
+    }
+
+    printf(
+        "%dx%d, %d blocks, %s\n", BENCH_WDTH, BENCH_LN, BENCH_BLOCKS, pin ? "pinned" : "unpinned"
+    );
+    printf("%8s %12s %8s %12s %8s\n", "workers", "flat ms", "speedup", "nested ms", "speedup");
+    double flat_base = 0.0;
+    double nested_base = 0.0;
+    for (size_t w = 1; w <= cpus; ++w) {
+        TRY(excv, create_task_pool(w, pin, &pool), goto epilogue);
+        const double flat = run(pool, &ctx, tasks, false);
+        const double nested = run(pool, &ctx, tasks, true);
+        destroy_task_pool(&pool);
+        if (w == 1) {
+            flat_base = flat;
+            nested_base = nested;
+        }
+        printf(
+            "%8zu %12.3f %8.2f %12.3f %8.2f\n", w, flat, flat_base / flat, nested,
+            nested_base / nested
+        );
+    }
+epilogue:
+    destroy_task_pool(&pool);
+    if (ctx.done_ev) {
+        CloseHandle(ctx.done_ev);
+    }
+    free(tasks);
+    free(ctx.src);
+    free(ctx.dst);
+    return excv == TL_SUCCESS ? 0 : 1;
+}
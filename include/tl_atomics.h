@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Portable atomics built on C11 <stdatomic.h>.
+
+Every shared flag and index is polled from the hot loops of all threads, so reads are
+plain acquire loads instead of read-modify-write operations. An RMW takes the cache line
+exclusively and bounces it between cores even when nothing changed.
+
+Ordering used throughout:
+- Stores are release, so data written before a flag/index is published is visible to
+  whoever observes the new value.
+- Loads are acquire, pairing with the above.
+- `_relaxed` getters are for values only the calling thread writes (a ring index read by its
+  owner) or for informational reads (debug prints) where no ordering is needed.
+
+`atomic_size_t` is the standard C11 type and is used as-is.
+*/
+
+typedef _Atomic(int32_t)  atomic_bool_t;
+typedef _Atomic(uint64_t) atomic_double_t; // Bit pattern of a double.
+typedef _Atomic(void *)   atomic_ptr_t;
+
+/// @brief For byte reinterpretation.
+union double_u64 {
+    double   d;
+    uint64_t u64;
+};
+
+/// @brief Sets an atomic bool to a given value.
+/// @param b Target atomic variable.
+/// @param value Value to set to.
+static inline void set_atomic_bool(
+    atomic_bool_t *b,
+    bool           value
+) {
+    if (b == NULL) {
+        return;
+    }
+    atomic_store_explicit(b, (int32_t)value, memory_order_release);
+}
+
+/// @brief Gets the value held by an atomic bool.
+/// @param b Target atomic variable.
+/// @return Value of variable.
+static inline bool get_atomic_bool(atomic_bool_t *b) {
+    if (b == NULL) {
+        return false;
+    }
+    return atomic_load_explicit(b, memory_order_acquire) != 0;
+}
+
+/// @brief Flips an atomic bool. Internally uses a XOR flip.
+/// @param b Target atomic variable
+static inline void flip_atomic_bool(atomic_bool_t *b) {
+    if (b == NULL) {
+        return;
+    }
+    atomic_fetch_xor_explicit(b, 1, memory_order_acq_rel);
+}
+
+/// @brief Sets an atomic double to a given value.
+/// @param dbl Target atomic variable.
+/// @param value Value to set to.
+static inline void set_atomic_double(
+    atomic_double_t *dbl,
+    double           value
+) {
+    if (dbl == NULL) {
+        return;
+    }
+    union double_u64 du64;
+    du64.d = value;
+    atomic_store_explicit(dbl, du64.u64, memory_order_release);
+}
+
+/// @brief Gets the value held by an atomic double.
+/// @param dbl Target atomic variable.
+/// @return Value of variable.
+static inline double get_atomic_double(atomic_double_t *dbl) {
+    if (dbl == NULL) {
+        return 0.0;
+    }
+    union double_u64 du64;
+    du64.u64 = atomic_load_explicit(dbl, memory_order_acquire);
+    return du64.d;
+}
+
+/// @brief Adds a given value to a target atomic double.
+/// @param dbl Target atomic double.
+/// @param addend Value to be added to variable.
+static inline void add_atomic_double(
+    atomic_double_t *dbl,
+    double           addend
+) {
+    if (dbl == NULL) {
+        return;
+    }
+    union double_u64 expected;
+    union double_u64 desired;
+    expected.u64 = atomic_load_explicit(dbl, memory_order_relaxed);
+    do {
+        desired.d = expected.d + addend;
+
+        // `expected` is refreshed with the current value on failure.
+    } while (!atomic_compare_exchange_weak_explicit(
+        dbl, &expected.u64, desired.u64, memory_order_acq_rel, memory_order_relaxed
+    ));
+}
+
+/// @brief Sets an atomic size_t to a given value.
+/// @param st Target atomic variable.
+/// @param value Value to be set to.
+static inline void set_atomic_size_t(
+    atomic_size_t *st,
+    size_t         value
+) {
+    if (st == NULL) {
+        return;
+    }
+    atomic_store_explicit(st, value, memory_order_release);
+}
+
+/// @brief Gets the value held by an atomic size_t.
+/// @param st Target atomic variable.
+/// @return Value of variable.
+static inline size_t get_atomic_size_t(atomic_size_t *st) {
+    if (st == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(st, memory_order_acquire);
+}
+
+/// @brief Gets the value held by an atomic size_t without ordering guarantees.
+/// @param st Target atomic variable. Should only be written to by the calling thread.
+/// @return Value of variable.
+static inline size_t get_atomic_size_t_relaxed(atomic_size_t *st) {
+    if (st == NULL) {
+        return 0;
+    }
+    return atomic_load_explicit(st, memory_order_relaxed);
+}
+
+/// @brief Adds a value to a target atomic size_t.
+/// @param st Target atomic variable.
+/// @param addend Value to be added to the variable.
+static inline void add_atomic_size_t(
+    atomic_size_t *st,
+    size_t         addend
+) {
+    if (st == NULL) {
+        return;
+    }
+    atomic_fetch_add_explicit(st, addend, memory_order_acq_rel);
+}
+
+/// @brief Gets the pointer held by an atomic pointer.
+/// @param p Target atomic variable.
+/// @return Value of variable.
+static inline void *get_atomic_ptr(atomic_ptr_t *p) {
+    if (p == NULL) {
+        return NULL;
+    }
+    return atomic_load_explicit(p, memory_order_acquire);
+}
+
+/// @brief Swaps the pointer held by an atomic pointer. Used to hand over ownership.
+/// @param p Target atomic variable.
+/// @param value New pointer.
+/// @return Previous pointer.
+static inline void *exchange_atomic_ptr(
+    atomic_ptr_t *p,
+    void         *value
+) {
+    if (p == NULL) {
+        return NULL;
+    }
+    return atomic_exchange_explicit(p, value, memory_order_acq_rel);
+}
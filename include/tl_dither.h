@@ -0,0 +1,195 @@
+#pragma once
+
+#include "tl_errors.h"
+#include "tl_pool.h"
+#include "tl_types.h"
+
+/*
+Frames past the scaler are braille cell-tiled: each cell's 2x4 pixels are stored as 8 contiguous
+bytes, cells in row-major order. Byte `k` of a cell is the pixel behind dot bit `k` of its mask,
+so packing a cell is a single 64-bit load and dithers that work per pixel stream straight through.
+*/
+
+/// @brief Byte offset of dot bit `k` within a tiled cell, from its position in the cell.
+/// @param dx Column within the cell. (0-1)
+/// @param dy Row within the cell. (0-3)
+/// @return Byte offset within the cell.
+static inline size_t tiled_dot_idx(
+    const size_t dx,
+    const size_t dy
+) {
+    // Dots 1-6 run down the two columns, dots 7 and 8 make up the bottom row.
+    return dy == BRAILLE_CHAR_DOT_LN - 1 ? 6 + dx : dx * 3 + dy;
+}
+
+/// @brief Index of pixel (x, y) in a tiled frame.
+/// @param cell_wdth Frame width in cells.
+/// @param x Column in pixels.
+/// @param y Row in pixels.
+/// @return Index into the frame data.
+static inline size_t tiled_px_idx(
+    const size_t cell_wdth,
+    const size_t x,
+    const size_t y
+) {
+    const size_t cell = (y / BRAILLE_CHAR_DOT_LN) * cell_wdth + x / BRAILLE_CHAR_DOT_WDTH;
+    return cell * BRAILLE_DOTS_PER_CHAR +
+           tiled_dot_idx(x % BRAILLE_CHAR_DOT_WDTH, y % BRAILLE_CHAR_DOT_LN);
+}
+
+/// @brief Rectangle of cells.
+typedef struct cell_rect {
+    size_t col;
+    size_t row;
+    size_t wdth;
+    size_t ln;
+} cell_rect;
+
+/// @brief Dithering state that persists across frames. (e.g. Textures, tiled matrices)
+/// @note Not shared, every thread that dithers keeps its own.
+typedef struct dither_ctx {
+    uint8_t matrices[DTH_MODES][BAYER_16X16_MATRIX_SIZE]; // Tiled threshold matrices by mode.
+    bool    matrix_set[DTH_MODES];
+
+    // Pattern matching, set up on first use.
+    uint16_t blur_weights[BRAILLE_DOTS_PER_CHAR * BRAILLE_DOTS_PER_CHAR]; // By output, then input.
+    uint8_t  patterns[BRAILLE_PATTERNS * BRAILLE_DOTS_PER_CHAR];         // Every mask, blurred.
+    uint8_t  flat_masks[UINT8_MAX + 1]; // Best mask for a flat cell, by luminance.
+    bool     patterns_set;
+
+    const uint8_t *blue_tile; // Tiled blue noise, `BNOISE_SIDE` square. Not owned.
+    task_pool     *pool;      // Splits frames for the modes that can. Not owned, can be NULL.
+    double         pts;       // Frame time in seconds, set by the caller. Blue noise cycles on it.
+    int16_t       *err_buf;   // Error diffusion rows, or a whole frame of error for block mode.
+    size_t         err_count;
+
+    // Temporal hysteresis, set by the caller. Only for modes that pass `dither_reusable()`.
+    bool           stable;     // Keeps textures from cycling between frames.
+    const uint8_t *prev_masks; // Dots of the previous frame, same bounds. NULL for none.
+} dither_ctx;
+
+/// @brief Creates and allocates a `dither_ctx` to a NULL-ed out-parameter.
+/// @param blue_tile Tile from `create_blue_tile()`. Has to outlive the context.
+/// @param pool Pool dot and block diffusion spread a frame over, when called from one of its
+/// tasks. Can be NULL. Has to outlive the context.
+/// @param out Out-parameter to hold created context.
+/// @return Return code.
+tl_result create_dither_ctx(
+    const uint8_t *blue_tile,
+    task_pool     *pool,
+    dither_ctx   **out
+);
+
+/// @brief Corresponding destroy function to free struct.
+/// @param ctx_ptr Address of pointer to context.
+void destroy_dither_ctx(dither_ctx **ctx_ptr);
+
+/// @brief Loads the blue noise tile, shared by every context. Generated with void-and-cluster the
+/// first time, then cached next to the executable.
+/// @param out Out-parameter to hold the tile. `BNOISE_SIDE` square, tiled like frames.
+/// @return Return code.
+tl_result create_blue_tile(uint8_t **out);
+
+/// @brief Corresponding destroy function to free the tile.
+/// @param tile_ptr Address of pointer to tile.
+void destroy_blue_tile(uint8_t **tile_ptr);
+
+/// @brief Applies the given dithering algorithm in-place. Output pixels are either 0 or 255.
+/// @param ctx Calling thread's dithering context.
+/// @param dmode Dithering mode.
+/// @param rframe Tiled raw frame to dither.
+/// @return Return code.
+tl_result apply_dither(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    raw_frame        *rframe
+);
+
+/// @brief Like `apply_dither()`, but only over some cells. Only for modes that pass
+/// `dither_reusable()` under `ctx->stable`, the others can't be cut up without seams.
+/// @param ctx Calling thread's dithering context.
+/// @param dmode Dithering mode.
+/// @param rframe Tiled raw frame to dither.
+/// @param rect Cells to dither.
+/// @return Return code.
+tl_result apply_dither_rect(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    raw_frame        *rframe,
+    const cell_rect  *rect
+);
+
+/// @brief Packs a dithered raw frame into braille dot masks, one byte per cell. Bit `n` is dot
+/// `n + 1` of the Unicode braille pattern, so that a mask maps straight to its glyph.
+/// @param rframe Dithered tiled raw frame.
+/// @param cells Output buffer, holds (flength / 4) * (fwidth / 2) masks.
+void pack_braille(
+    const raw_frame *rframe,
+    uint8_t         *cells
+);
+
+/// @brief Like `pack_braille()`, but only packs some cells. The others are left as they are.
+/// @param rframe Dithered tiled raw frame.
+/// @param rect Cells to pack.
+/// @param cells Output buffer for the whole frame.
+void pack_braille_rect(
+    const raw_frame *rframe,
+    const cell_rect *rect,
+    uint8_t         *cells
+);
+
+/// @brief Hashes a packed braille grid. Used to compare rendered output across builds.
+/// @param cells Dot masks.
+/// @param count Cell count.
+/// @return 64-bit FNV-1a hash of the grid.
+uint64_t hash_cells(
+    const uint8_t *cells,
+    const size_t   count
+);
+
+/// @brief Whether a mode diffuses error. Those cost the most and can't be split within a frame.
+/// @param dmode Dithering mode.
+/// @return True for error diffusion modes.
+static inline bool dither_diffuses(const dither_mode dmode) {
+#define X(mode, fn, str, div, ...) dmode == mode ||
+    return DIFFUSION_LIST false;
+#undef X
+}
+
+/// @brief Whether a mode thresholds pixels against a fixed matrix or texture. Those are the
+/// cheapest, and what the quality governor swaps the others for.
+/// @param dmode Dithering mode.
+/// @return True for Bayer, halftone, blue noise and plain thresholding.
+static inline bool dither_ordered(const dither_mode dmode) {
+    return dmode == DTH_BAYER_16X16 || dmode == DTH_BAYER_8X8 || dmode == DTH_BAYER_4X4 ||
+           dmode == DTH_HALFTONE || dmode == DTH_BLUE || dmode == DTH_THRESHOLDING;
+}
+
+/// @brief Whether a mode's output for a pixel only depends on its value and position, or on its
+/// own `DOT_CLASS_SIDE` block. Those can dither parts of a frame on their own, reuse cells from
+/// earlier frames, and hold dots in place with hysteresis, where they threshold.
+/// @param dmode Dithering mode.
+/// @param stable Whether textures stay put between frames. (`dither_ctx.stable`)
+/// @return True for ordered modes, dot diffusion and pattern matching. Blue noise only when it
+/// stays put.
+static inline bool dither_reusable(
+    const dither_mode dmode,
+    const bool        stable
+) {
+    return !dither_diffuses(dmode) && dmode != DTH_BLOCK_DIFFUSION &&
+           (dmode != DTH_BLUE || stable);
+}
+
+/// @brief Expands a dot mask to its braille glyph, UTF-8 encoded. Only done at output time.
+/// @param mask Dot mask.
+/// @param out Buffer of at least `BRAILLE_UTF8_BSIZE` bytes.
+static inline void braille_utf8(
+    const uint8_t mask,
+    char         *out
+) {
+    // U+2800 to U+28FF lays the 256 patterns out in mask order, so the mask splits straight into
+    // the two continuation bytes.
+    out[0] = (char)(0xE0 | (BRAILLE_BASE_CODEPOINT >> 12));
+    out[1] = (char)(0x80 | ((BRAILLE_BASE_CODEPOINT >> 6) & 0x3F) | (mask >> 6));
+    out[2] = (char)(0x80 | (mask & 0x3F));
+}
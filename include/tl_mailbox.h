@@ -0,0 +1,99 @@
+#pragma once
+
+#include "tl_errors.h"
+#include "tl_types.h"
+
+/*
+Single-slot, latest-wins mailbox between the video consumer and the terminal writer.
+The status line from the input thread gets its own slot, so the writer can put both in the same
+write.
+
+Three buffers rotate between the two threads. The presenter fills its back buffer and posts
+it, which swaps it with the slot. The writer takes the slot by swapping it with its front buffer.
+Nothing is queued: a frame posted before the writer took the previous one replaces it, so the
+writer only ever sees the newest frame, and the presenter never waits on the terminal.
+
+A screen clear can't be lost that way. When a frame that asked for one gets replaced, the
+replacing frame inherits the request.
+*/
+
+/// @brief Frame ready to be written to the console.
+typedef struct out_frame {
+    char  *bytes; // VT sequences and UTF-8 glyphs.
+    size_t capacity;
+    size_t length; // 0 when the frame only clears the screen.
+    bool   clear;  // Clear the screen first.
+    size_t serial;
+    double posted_at; // `mono_time()` of the post.
+} out_frame;
+
+/// @brief Latest-wins mailbox.
+typedef struct frame_mailbox {
+    out_frame  frames[3];
+    out_frame *back;  // Presenter's.
+    out_frame *slot;  // Posted, under `srw_slot`.
+    out_frame *front; // Writer's.
+    bool       fresh; // Slot holds a frame not taken yet. Under `srw_slot`.
+
+    // Latest status line, under `srw_slot` as well.
+    char    status[GBUFFER_BSIZE];
+    size_t  status_length;
+    bool    status_fresh;
+    SRWLOCK srw_slot;
+    HANDLE  post_ev; // Writer's wake event, signaled on every post. Not owned.
+} frame_mailbox;
+
+/// @brief Creates and allocates a `frame_mailbox` to a NULL-ed out-parameter.
+/// @param post_ev Event to signal when a frame is posted.
+/// @param out Out-parameter to hold created mailbox.
+/// @return Return code.
+tl_result create_frame_mailbox(
+    HANDLE          post_ev,
+    frame_mailbox **out
+);
+
+/// @brief Corresponding destroy function to free struct.
+/// @param mb_ptr Address of pointer to mailbox.
+void destroy_frame_mailbox(frame_mailbox **mb_ptr);
+
+/// @brief Presenter only. Returns the back buffer, emptied, with room for at least `bsize` bytes.
+/// @param mb Mailbox.
+/// @param bsize Byte count the frame needs.
+/// @param out Out-parameter to hold the back buffer.
+/// @return Return code.
+tl_result mailbox_back(
+    frame_mailbox *mb,
+    const size_t   bsize,
+    out_frame    **out
+);
+
+/// @brief Presenter only. Posts the back buffer.
+/// @param mb Mailbox.
+/// @return True when an earlier frame the writer hadn't taken yet got replaced.
+bool mailbox_post(frame_mailbox *mb);
+
+/// @brief Writer only. Takes the newest posted frame.
+/// @param mb Mailbox.
+/// @return The frame, valid until the next take. NULL when nothing new was posted.
+out_frame *mailbox_take(frame_mailbox *mb);
+
+/// @brief Input thread only. Posts the status line, replacing the last one.
+/// @param mb Mailbox.
+/// @param line Status line, without VT sequences. Cut short at `GBUFFER_BSIZE` bytes.
+/// @param length Length of `line` in bytes.
+void mailbox_post_status(
+    frame_mailbox *mb,
+    const char    *line,
+    const size_t   length
+);
+
+/// @brief Writer only. Copies the newest status line, if one was posted since the last take.
+/// @param mb Mailbox.
+/// @param out Buffer of `GBUFFER_BSIZE` bytes.
+/// @param length_out Out-parameter to hold the length of the line.
+/// @return True when there was a new line.
+bool mailbox_take_status(
+    frame_mailbox *mb,
+    char          *out,
+    size_t        *length_out
+);
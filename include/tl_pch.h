@@ -16,6 +16,7 @@
 #include <io.h>
 #include <fcntl.h>
 #include <conio.h>
+#include <emmintrin.h>
 #include "lz4.h"
 #include "miniaudio.h"
 
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "tl_errors.h"
+#include "tl_types.h"
+
+/*
+Work-stealing task pool. Shared compute runtime for short, independent jobs.
+
+Every worker owns a fixed-size Chase-Lev deque. The owner pushes and pops at the bottom, idle
+workers steal from the top of the others'. Tasks submitted from outside the pool go through a
+locked injection queue instead, as do tasks a worker submits while its own deque is full.
+Idle workers sleep on a semaphore released once per submission.
+
+Tasks are intrusive and owned by the submitter, who must keep them alive until they have run.
+Nothing is allocated per task.
+
+A task can also split its own work with `pool_parallel_for()`. The helpers go on the caller's
+deque, where idle workers steal them. The caller works through the items as well, then takes back
+the helpers nobody got to, along with their wakeups. It sleeps on its worker's event until the
+stolen ones finish, rather than running unrelated tasks, so per-worker scratch state stays its own.
+*/
+
+#define POOL_DEQUE_CAPACITY 256 // Per worker. Power of two.
+#define POOL_FOR_HELPERS 16     // Most helpers `pool_parallel_for()` submits.
+#define POOL_FOR_SPINS 256      // Polls on stolen helpers before `pool_parallel_for()` sleeps.
+
+typedef struct pool_task pool_task;
+
+/// @brief Task entry point.
+/// @param task The task being run.
+/// @param worker Index of the running worker, below `pool_worker_count()`. Lets tasks keep
+/// per-worker scratch state without locking.
+typedef void (*pool_task_fn)(pool_task *task, size_t worker);
+
+/// @brief `pool_parallel_for()` item body.
+/// @param arg Shared argument.
+/// @param item Index of the item to run.
+typedef void (*pool_for_fn)(void *arg, size_t item);
+
+/// @brief Task. Usually embedded in a bigger struct, which `arg` can point back to.
+typedef struct pool_task {
+    pool_task_fn fn;
+    void        *arg;
+    pool_task   *next; // Injection queue link. Owned by the pool.
+} pool_task;
+
+/// @brief Chase-Lev deque of `pool_task*`s.
+typedef struct task_deque {
+    // Owner.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t bottom;
+
+    // Thieves.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t top;
+
+    _Alignas(CACHE_LINE_BSIZE) atomic_ptr_t slots[POOL_DEQUE_CAPACITY];
+} task_deque;
+
+typedef struct task_pool task_pool;
+
+/// @brief Pool worker.
+typedef struct pool_worker {
+    task_deque deque;
+    task_pool *pool;
+    size_t     idx;
+    size_t     victim; // Where the next steal attempt starts.
+    HANDLE     thread;
+    HANDLE     for_done; // Auto-reset. Set by the last helper of its `pool_parallel_for()` to end.
+} pool_worker;
+
+/// @brief Task pool.
+typedef struct task_pool {
+    pool_worker  *workers; // Allocated with `_aligned_malloc()` to keep the deque alignment.
+    size_t        worker_count;
+    atomic_bool_t stop;
+    HANDLE        work_sem; // Released once per submission, idle workers wait on it.
+    SRWLOCK       srw_inject;
+    pool_task    *inject_head; // Injection queue, FIFO. Under `srw_inject`.
+    pool_task    *inject_tail;
+} task_pool;
+
+/// @brief Creates and allocates a `task_pool` to a NULL-ed out-parameter and starts its workers.
+/// @param worker_count Number of workers. 0 starts one per logical processor.
+/// @param pin_threads Pins worker `i` to logical processor `i`.
+/// @param out Out-parameter to hold created pool.
+/// @return Return code.
+tl_result create_task_pool(
+    const size_t worker_count,
+    const bool   pin_threads,
+    task_pool  **out
+);
+
+/// @brief Corresponding destroy function to free struct. Stops and joins the workers first.
+/// @param pool_ptr Address of pointer to pool.
+/// @note Tasks that haven't started by then never run.
+void destroy_task_pool(task_pool **pool_ptr);
+
+/// @brief Queues a task. Can be called from any thread, including from within a task.
+/// @param pool Task pool.
+/// @param task Task to run. `fn` must be set.
+void pool_submit(
+    task_pool *pool,
+    pool_task *task
+);
+
+/// @brief Worker count, which per-worker state has to be sized to.
+/// @param pool Task pool.
+/// @return Worker count.
+size_t pool_worker_count(const task_pool *pool);
+
+/// @brief Runs `fn` on every item below `count`, spread over idle workers, and returns once all of
+/// them have run. Items run in no particular order and must not depend on each other.
+/// @param pool Task pool.
+/// @param count Item count.
+/// @param fn Item body.
+/// @param arg Passed to `fn`.
+/// @note From outside the pool, every item runs on the calling thread.
+void pool_parallel_for(
+    task_pool        *pool,
+    const size_t      count,
+    const pool_for_fn fn,
+    void             *arg
+);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "tl_dither.h"
+#include "tl_errors.h"
+#include "tl_pool.h"
+#include "tl_scale.h"
+#include "tl_types.h"
+
+/*
+Parallel frame rendering. (Scaling, dithering, packing)
+
+Frames don't depend on each other until they get temporally encoded, so every job renders a whole
+frame on its own as a task on the shared pool. Jobs carry a sequence number, the dispatcher hands
+them out, then puts them back in order before encoding and publishing.
+
+Scalers, dithering contexts and scratch frames are kept per pool worker, and a worker only ever
+runs one task at a time, so jobs never share them.
+
+With ordered dithers, dot diffusion and pattern matching, a job can be handed a reference: an
+earlier job, already rendered, that stays untouched until the job is done with it. Blocks of cells
+that barely changed since the reference are copied from it, only the others get dithered. Ordered
+dithers only look at a pixel and its position, the others at its own block or cell, so the copied
+blocks line up with the new ones without seams.
+Stable jobs also hold the reference's dots in place with hysteresis.
+*/
+
+// Jobs in flight, plus the reference and as many older ones they may still pin, one each at most.
+#define RENDER_JOBS (2 * VRAW_FRAMES + 1)
+
+typedef struct renderer   renderer;
+typedef struct render_job render_job;
+
+/// @brief One frame to render.
+typedef struct render_job {
+    // Filled in by the dispatcher.
+    dec_frame  *dframe;
+    con_bounds  bounds;
+    dither_mode dmode;
+    bool        stable; // Temporal hysteresis on dots, see `dither_ctx`.
+    size_t      seq;    // Dispatch order.
+    size_t      serial; // Serial of `dframe`.
+    size_t      layout; // Console layout `bounds` belongs to.
+    double      pts;
+
+    render_job *ref; // Rendered job to reuse cells from, read-only to the task. Can be NULL.
+
+    // Filled in by the task.
+    uint8_t  *masks;        // Dot masks, one per cell. Sized for `MAXIMUM_BUFFER_SIZE` dots.
+    uint8_t  *luma;         // Tiled luminance `masks` were dithered from. Only kept when reusable.
+    uint64_t  hash;         // Hash of `masks`.
+    bool      supported;    // False when the bounds can't be rendered. `masks` is unset.
+    size_t    reused_cells; // Cells copied from `ref`.
+    double    cost_s;       // Time spent rendering.
+    tl_result excv;
+
+    // Dispatcher's. A job stays out of the free list while it is the reference or pinned.
+    size_t pins; // Jobs in flight referencing this one.
+    bool   held; // Current reference.
+
+    // Owned by the renderer.
+    pool_task     task;
+    renderer     *rd;
+    atomic_bool_t done; // Set once everything above is.
+} render_job;
+
+/// @brief Scratch state of one pool worker.
+typedef struct render_ctx {
+    dither_ctx  *dctx;
+    area_scaler *scaler;
+    raw_frame   *scaled; // Tiled scratch frame.
+} render_ctx;
+
+/// @brief Frame renderer running on a task pool.
+typedef struct renderer {
+    task_pool  *pool; // Not owned.
+    render_ctx *ctxs; // One per pool worker.
+    size_t      ctx_count;
+    HANDLE      done_ev; // Dispatcher's wake event, signaled on completion. Not owned.
+} renderer;
+
+/// @brief Creates and allocates a `renderer` to a NULL-ed out-parameter.
+/// @param pool Task pool to render on.
+/// @param blue_tile Blue noise tile from `create_blue_tile()`. Has to outlive the renderer.
+/// @param done_ev Event to signal when a job completes.
+/// @param out Out-parameter to hold created renderer.
+/// @return Return code.
+tl_result create_renderer(
+    task_pool     *pool,
+    const uint8_t *blue_tile,
+    HANDLE         done_ev,
+    renderer     **out
+);
+
+/// @brief Corresponding destroy function to free struct.
+/// @param rd_ptr Address of pointer to renderer.
+/// @note Every submitted job has to be done first.
+void destroy_renderer(renderer **rd_ptr);
+
+/// @brief Queues a job on the pool.
+/// @param rd Renderer.
+/// @param job Job to render. Owned by the renderer until `render_done()` returns true.
+void render_submit(
+    renderer   *rd,
+    render_job *job
+);
+
+/// @brief Whether a submitted job has finished rendering.
+/// @param job Submitted job.
+/// @return True once the job's results can be read.
+static inline bool render_done(render_job *job) { return get_atomic_bool(&job->done); }
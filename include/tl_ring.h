@@ -0,0 +1,191 @@
+#pragma once
+
+#include "tl_errors.h"
+#include "tl_types.h"
+
+/*
+Lock-free single-producer/single-consumer ring buffer.
+
+Indices are free-running and only ever increase, the slot is `index % capacity`. The producer
+owns `tail`, the consumer owns `head`, each on its own cache line along with a cached copy of
+the other side's index so that the shared line is only read when the cached one runs out.
+
+Flushing is serial-aware. When the producer switches to a new serial it calls `spsc_mark()`
+before pushing anything for it. The consumer calls `spsc_flush()` with the serial it is on,
+which drops (and destroys, through `drop`) everything pushed before the mark. Until the producer
+has marked that serial, the flush keeps dropping whatever stale entries arrive and reports that
+the ring isn't in sync yet. Nobody but the consumer ever moves `head`.
+*/
+
+/// @brief Returns true when a blocking ring operation should give up.
+typedef bool (*spsc_cancel_fn)(void *ctx);
+
+/// @brief Lock-free single-producer/single-consumer ring buffer.
+typedef struct spsc_ring {
+    // Consumer.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t head;
+    size_t cached_tail;
+    size_t synced_serial; // Serial the consumer last finished flushing to.
+
+    // Producer.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t tail;
+    size_t        cached_head;
+    atomic_size_t mark_idx;    // First index pushed under `mark_serial`.
+    atomic_size_t mark_serial; // Serial of the last `spsc_mark()`.
+
+    // Set up by `create_spsc_ring()`, read-only afterwards.
+    _Alignas(CACHE_LINE_BSIZE) uint8_t *slots;
+    size_t capacity; // In elements.
+    size_t elem_bsize;
+    void (*drop)(void *elem); // Destroys a flushed element. Can be NULL.
+    HANDLE space_ev;          // Signaled after a pop. Producer's wake event. Can be NULL.
+    HANDLE data_ev;           // Signaled after a push. Consumer's wake event. Can be NULL.
+} spsc_ring;
+
+/// @brief Creates and allocates a `spsc_ring` to a NULL-ed out-parameter.
+/// @param capacity Element count.
+/// @param elem_bsize Size of each element in bytes.
+/// @param drop Destroys an element dropped by a flush, receives a pointer to its slot. Can be NULL.
+/// @param space_ev Event to signal when space frees up. Can be NULL.
+/// @param data_ev Event to signal when data arrives. Can be NULL.
+/// @param out Out-parameter to hold created ring.
+/// @return Return code.
+tl_result create_spsc_ring(
+    const size_t capacity,
+    const size_t elem_bsize,
+    void (*drop)(void *elem),
+    HANDLE      space_ev,
+    HANDLE      data_ev,
+    spsc_ring **out
+);
+
+/// @brief Corresponding destroy function to free struct. Drops any elements left.
+/// @param ring_ptr Address of pointer to ring.
+/// @note Only call once both sides have stopped.
+void destroy_spsc_ring(spsc_ring **ring_ptr);
+
+/// @brief Pushes up to `count` elements. Producer only.
+/// @param ring Ring.
+/// @param src Elements to push.
+/// @param count Element count.
+/// @return Number of elements pushed.
+size_t spsc_push(
+    spsc_ring  *ring,
+    const void *src,
+    const size_t count
+);
+
+/// @brief Pushes all `count` elements, blocking on `space_ev` while the ring is full. Producer
+/// only.
+/// @param ring Ring.
+/// @param src Elements to push.
+/// @param count Element count.
+/// @param cancel Checked before every wait. Returning true stops the push.
+/// @param ctx Passed to `cancel`.
+/// @return True if every element was pushed.
+bool spsc_push_wait(
+    spsc_ring     *ring,
+    const void    *src,
+    const size_t   count,
+    spsc_cancel_fn cancel,
+    void          *ctx
+);
+
+/// @brief Pops up to `count` elements. Consumer only.
+/// @param ring Ring.
+/// @param dst Destination of the popped elements.
+/// @param count Element count.
+/// @return Number of elements popped.
+size_t spsc_pop(
+    spsc_ring   *ring,
+    void        *dst,
+    const size_t count
+);
+
+/// @brief Pops all `count` elements, blocking on `data_ev` while the ring is empty. Consumer
+/// only.
+/// @param ring Ring.
+/// @param dst Destination of the popped elements.
+/// @param count Element count.
+/// @param cancel Checked before every wait. Returning true stops the pop.
+/// @param ctx Passed to `cancel`.
+/// @return True if every element was popped.
+bool spsc_pop_wait(
+    spsc_ring     *ring,
+    void          *dst,
+    const size_t   count,
+    spsc_cancel_fn cancel,
+    void          *ctx
+);
+
+/// @brief Copies up to `count` elements from the front without popping them. Consumer only.
+/// @param ring Ring.
+/// @param dst Destination of the copied elements.
+/// @param count Element count.
+/// @return Number of elements copied.
+size_t spsc_peek(
+    spsc_ring   *ring,
+    void        *dst,
+    const size_t count
+);
+
+/// @brief Elements ready to be popped. Consumer only.
+/// @param ring Ring.
+/// @return Element count.
+size_t spsc_size(spsc_ring *ring);
+
+/// @brief Marks the start of a new serial. Producer only, before pushing anything for it.
+/// @param ring Ring.
+/// @param serial New serial.
+void spsc_mark(
+    spsc_ring   *ring,
+    const size_t serial
+);
+
+/// @brief Drops every element pushed before the producer's mark for `serial`. Consumer only.
+/// Cheap when already in sync.
+/// @param ring Ring.
+/// @param serial Serial the consumer is on.
+/// @return True when the ring only holds elements of `serial`. While false, nothing popped can
+/// be trusted to belong to it.
+bool spsc_flush(
+    spsc_ring   *ring,
+    const size_t serial
+);
+
+/// @brief Pushes a frame to a frame queue. Producer only.
+/// @param fq Ring of `con_frame*`s.
+/// @param frame Frame. Ownership passes to the queue on success. Can be NULL. (Empty frame)
+/// @param cancel Checked before every wait. Returning true stops the push.
+/// @param ctx Passed to `cancel`.
+/// @return True if the frame was queued.
+static inline bool push_conframe(
+    spsc_ring     *fq,
+    con_frame     *frame,
+    spsc_cancel_fn cancel,
+    void          *ctx
+) {
+    return spsc_push_wait(fq, &frame, 1, cancel, ctx);
+}
+
+/// @brief Pops a frame from a frame queue. Consumer only.
+/// @param fq Ring of `con_frame*`s.
+/// @param out Out-parameter to hold the frame. Ownership passes to the caller.
+/// @return True if a frame was popped. The frame itself can still be NULL. (Empty frame)
+static inline bool pop_conframe(
+    spsc_ring  *fq,
+    con_frame **out
+) {
+    return spsc_pop(fq, out, 1) == 1;
+}
+
+/// @brief Looks at the next frame of a frame queue without popping it. Consumer only.
+/// @param fq Ring of `con_frame*`s.
+/// @param out Out-parameter to hold the frame. Still owned by the queue.
+/// @return True if there is a next frame. The frame itself can still be NULL. (Empty frame)
+static inline bool peek_conframe(
+    spsc_ring  *fq,
+    con_frame **out
+) {
+    return spsc_peek(fq, out, 1) == 1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "tl_errors.h"
+#include "tl_types.h"
+
+/*
+Separable area (box) resampling of 8-bit grayscale frames.
+
+Each destination pixel is the average of the source area it covers, weighted by how much of
+each source pixel falls inside it. The weights only depend on the sizes involved, so they are
+computed once per size pair and kept in Q12 fixed point, summing to exactly 1 << 12 per pixel.
+
+The vertical pass runs first, over full source rows, and only touches contiguous memory so it
+vectorizes. The horizontal pass then has far fewer rows left to go through, and writes its output
+straight into the braille cell-tiled layout (see tl_dither.h) so that no separate pass is needed.
+*/
+
+#define SCALE_WEIGHT_BITS 12
+#define SCALE_ROW_BITS 8 // Extra precision kept between the two passes.
+
+/// @brief Weights for one axis.
+typedef struct scale_axis {
+    size_t   *start;   // First source index per destination index.
+    uint16_t *weights; // `taps` weights per destination index, zero-padded.
+    size_t    taps;
+} scale_axis;
+
+/// @brief Area scaler for a fixed pair of sizes.
+typedef struct area_scaler {
+    size_t     src_wdth;
+    size_t     src_ln;
+    size_t     dst_wdth;
+    size_t     dst_ln;
+    scale_axis x;
+    scale_axis y;
+    uint32_t  *row; // One vertically resampled source row.
+} area_scaler;
+
+/// @brief Creates and allocates an `area_scaler` to a NULL-ed out-parameter.
+/// @param src_wdth Source width in pixels.
+/// @param src_ln Source height in pixels.
+/// @param dst_wdth Destination width in pixels. Multiple of `BRAILLE_CHAR_DOT_WDTH`.
+/// @param dst_ln Destination height in pixels. Multiple of `BRAILLE_CHAR_DOT_LN`.
+/// @param out Out-parameter to hold created scaler.
+/// @return Return code.
+tl_result create_area_scaler(
+    const size_t  src_wdth,
+    const size_t  src_ln,
+    const size_t  dst_wdth,
+    const size_t  dst_ln,
+    area_scaler **out
+);
+
+/// @brief Corresponding destroy function to free struct.
+/// @param scaler_ptr Address of pointer to scaler.
+void destroy_area_scaler(area_scaler **scaler_ptr);
+
+/// @brief Resamples a frame to the scaler's destination size, tiling it on the way out.
+/// @param scaler Scaler. Its source size must match `src`.
+/// @param src Row-major source frame.
+/// @param dst Tiled destination frame. Its buffer must hold the destination size.
+/// @return Return code.
+tl_result area_scale(
+    const area_scaler *scaler,
+    const raw_frame   *src,
+    raw_frame         *dst
+);
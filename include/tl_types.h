@@ -3,24 +3,95 @@
 #include <Windows.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "tl_atomics.h"
 
 typedef struct con_frame {
-    char  *compressed_data;
-    size_t compressed_bsize;
-    size_t uncompressed_bsize;
-    size_t flength; // Character cells that the frame occupies.
-    size_t fwidth;  // Character cells that the frame occupies.
-    size_t x_start;
-    size_t y_start;
-    double pts;
+    char    *compressed_data;
+    size_t   compressed_bsize;
+    size_t   uncompressed_bsize;
+    size_t   flength; // Character cells that the frame occupies.
+    size_t   fwidth;  // Character cells that the frame occupies.
+    size_t   x_start;
+    size_t   y_start;
+    double   pts;
+    uint64_t hash;          // Hash of the uncompressed dot masks.
+    size_t   changed_cells; // Cells that differ from the previous frame. All of them after a reset.
+    size_t   layout;        // Console layout the frame was sized for.
+    bool     keyframe;      // False when the data is XOR-ed against the previous frame's masks.
 } con_frame;
 
 typedef struct raw_frame {
     uint8_t *data;
     size_t   flength; // In pixels for the actual frame.
     size_t   fwidth;  // In pixels for the actual frame.
+    bool     tiled;   // Braille cell-tiled rather than row-major. See `tiled_px_idx()`.
 } raw_frame;
 
+/// @brief Decoded frame, handed from the reader thread to the converter. Pooled, see `player`.
+typedef struct dec_frame {
+    raw_frame frame;
+    double    pts;
+    size_t    serial; // Serial the frame was decoded under. Stale frames go back unconverted.
+} dec_frame;
+
+/// @brief Temporal frame codec state. One per encoding or decoding thread.
+/// @note Frames must go through it in order. A delta frame without a matching reference can't be
+/// decoded, which is why every frame is decoded, presented or not.
+typedef struct frame_codec {
+    uint8_t *cur;       // Delta of the frame in progress. Only used for decoding.
+    uint8_t *ref;       // Masks of the previous frame.
+    size_t   ref_cells; // Cells held in `ref`. 0 when there is no reference yet.
+    size_t   since_key; // Frames since the last keyframe.
+} frame_codec;
+
+/// @brief Render quality levels the quality governor steps through. Cheapest last.
+/// (Level, name, non-ordered dithering swapped for Bayer 8x8, cell resolution scale, render cost
+/// relative to full quality)
+#define QUALITY_LIST                                                                               \
+    X(QLT_FULL, "FULL", false, 1.0, 1.0)                                                           \
+    X(QLT_ORDERED, "ORDERED", true, 1.0, 0.5)                                                      \
+    X(QLT_ORDERED_75, "ORDERED 75%", true, 0.75, 0.28)                                             \
+    X(QLT_ORDERED_50, "ORDERED 50%", true, 0.5, 0.125)
+
+typedef enum quality_level {
+#define X(lvl, str, ordered, scale, cost) lvl,
+    QUALITY_LIST
+#undef X
+    QLT_LEVELS
+} quality_level;
+
+/// @brief Quality governor. Trades render quality for render time. Owned by the video producer.
+typedef struct quality_gov {
+    quality_level level;
+    double        load;       // EWMA of render cost over the frame budget. Above 1 falls behind.
+    double        changed_at; // `mono_time()` of the last step.
+    size_t        culled;     // Frames culled since the last evaluation.
+} quality_gov;
+
+/// @brief Output levels the output governor steps through. Cheapest last.
+/// (Level, name, frames per presented frame, cell resolution scale)
+#define OUTPUT_LIST                                                                                \
+    X(OUT_FULL, "FULL", 1, 1.0)                                                                    \
+    X(OUT_HALF_RATE, "1/2 FPS", 2, 1.0)                                                            \
+    X(OUT_HALF_RATE_75, "1/2 FPS 75%", 2, 0.75)                                                    \
+    X(OUT_THIRD_RATE_50, "1/3 FPS 50%", 3, 0.5)
+
+typedef enum output_level {
+#define X(lvl, str, rate_div, scale) lvl,
+    OUTPUT_LIST
+#undef X
+    OUT_LEVELS
+} output_level;
+
+/// @brief Output governor. Trades frame rate and resolution for output bandwidth, for terminals
+/// that can't take frames as fast as they come. Owned by the video writer.
+typedef struct output_gov {
+    output_level level;
+    double       write_s;    // EWMA of the time a frame write blocks.
+    double       bytes;      // EWMA of the bytes per frame written.
+    double       changed_at; // `mono_time()` of the last step.
+} output_gov;
+
 typedef struct con_bounds {
     size_t log_ln;
     size_t log_wdth;
@@ -32,10 +103,7 @@ typedef struct con_bounds {
     size_t abs_conwdth;
 } con_bounds;
 
-typedef volatile LONG32 atomic_bool_t;
-typedef volatile LONG64 atomic_size_t;
-typedef volatile LONG64 atomic_double_t;
-typedef int16_t         s16_le;
+typedef int16_t s16_le;
 
 #define EXT_KEYCODE 224
 #define ARR_UP_KEYC 72
@@ -44,19 +112,49 @@ typedef int16_t         s16_le;
 #define ARR_RIGHT_KEYC 77
 #define POLLING_RATE_MS 50
 #define POLLING_RATE_S 0.05
-#define MAX_THREADS 4
-#define MAX_EVENTS 2
-#define V_FPS 30
+#define MAX_THREADS 6
+#define MAX_EVENTS 6
+#define AUDIO_THREADS 2 // Threads (and events) that come first and run without video.
+#define V_FPS 30                // Fallback when the source frame rate is unusable.
+#define V_MAX_FPS 120           // Source frame rates above are taken as bogus.
+#define V_PRESENT_SLACK_S 0.001 // Frames this close to their deadline are presented right away.
+#define V_STILL_RUN_FRAMES 15   // Alike frames in a row before a scene counts as still.
+#define V_STILL_CELL_DIV 500    // Frames with no more than 1/500 of their cells changed are alike.
+#define V_STILL_REPAINT_S 1.0   // Longest small changes go unshown in a still scene.
+#define GOV_EWMA_ALPHA 0.1      // Weight of the newest frame in the render load.
+#define GOV_DOWN_LOAD 0.9       // Load above which quality steps down.
+#define GOV_UP_LOAD 0.6         // Load the next level up has to be expected to stay under.
+#define GOV_DOWN_HOLD_S 1.0     // Least time between a step and a step down.
+#define GOV_UP_HOLD_S 3.0       // Least time between a step and a step up.
+#define OUT_EWMA_ALPHA 0.2      // Weight of the newest write in the output averages.
+#define OUT_DOWN_SHARE 0.5      // Share of frame time spent writing above which output steps down.
+#define OUT_UP_SHARE 0.25       // Share the next level up has to be expected to stay under.
 #define A_SAMP_RATE 48000
 #define A_CHANNELS 2
 #define V_FRAME_INTERVALS 0.0334
+#define V_KEYFRAME_INTERVAL 60 // In frames. 1 turns off temporal compression.
 #define GBUFFER_BSIZE 500      // Generic buffer size.
 #define GLBUFFER_BSIZE 1000    // Generic long buffer size.
 #define GWVBUFFER_BSIZE 550000 // Generic work video buffer size. 550KB
-#define VBUFFER_BSIZE (V_FPS - 25) * sizeof(con_frame *)
+#define VBUFFER_FRAMES 16 // Video ring capacity.
+#define VRAW_FRAMES 8     // Decoded frames pooled between the video reader and converter.
+#define CHG_BLOCK_CELL_WDTH 8 // Change detection block, in cells.
+#define CHG_BLOCK_CELL_LN 2
+#define CHG_CELL_SAD 24 // Summed difference over a cell's pixels above which the cell changed.
 #define ABUFFER_BSIZE A_SAMP_RATE / 5 * A_CHANNELS * sizeof(s16_le)
 #define ASTREAM_BSIZE ABUFFER_BSIZE
 
+#define CACHE_LINE_BSIZE 64
+
+#define VT_SYNC_BEGIN "\x1b[?2026h" // Synchronized update (DEC mode 2026). Holds the repaint.
+#define VT_SYNC_END "\x1b[?2026l"   // Repaints everything written since `VT_SYNC_BEGIN` at once.
+#define VT_CLEAR "\x1b[2J"
+#define VT_HOME "\x1b[H"
+#define VT_ERASE_LINE "\x1b[K" // To the end of the line.
+#define VT_RESET "\x1b[0m"
+#define VT_CUP_BSIZE 16        // Room for a cursor position or color sequence.
+#define VT_WRITE_OVERHEAD 32   // Room for everything a write wraps around a frame and status line.
+
 #define MAXIMUM_RESOLUTION_WIDTH 1920
 #define MAXIMUM_RESOLUTION_HEIGHT 1080
 #define MAXIMUM_BUFFER_SIZE 3110400 // 2160 * 1440.
@@ -64,13 +162,22 @@ typedef int16_t         s16_le;
 #define BRAILLE_CHAR_DOT_LN 4
 #define BRAILLE_CHAR_DOT_WDTH 2
 #define BRAILLE_DOTS_PER_CHAR 8
+#define BRAILLE_BASE_CODEPOINT 0x2800 // Blank pattern.
+#define BRAILLE_UTF8_BSIZE 3
 #define BAYER_4X4_MATRIX_SIZE 16
 #define BAYER_8X8_MATRIX_SIZE 64
 #define BAYER_16X16_MATRIX_SIZE 256
-#define FLOYD_STEINBERG_KERNEL_SIZE 4
 #define HALFTONE_MATRIX_SIZE 16
-#define SIERRA_LITE_KERNEL_SIZE 2
 #define DTH_BLUE_MODES 4
+#define DTH_HYST_MARGIN 12 // Luminance a pixel has to cross its threshold by to flip its dot.
+#define BNOISE_SIDE 64     // Blue noise tile side. A power of two, and a multiple of 4.
+#define BNOISE_SIGMA 1.5   // Spread of the void-and-cluster energy filter, in pixels.
+#define DOT_CLASS_SIDE 8   // Dot diffusion class matrix side, and block side, in pixels.
+#define BLOCK_DIFF_SIDE 32 // Block error diffusion tile side, in pixels.
+#define BRAILLE_PATTERNS 256
+#define PTN_EDGE_RANGE 96   // Luminance range over a cell above which it holds an edge to match.
+#define PTN_FLAT_RANGE 4    // Luminance range over a cell below which it matches as flat.
+#define DTH_SPLIT_CELL_LN 8 // Cell rows per item when a frame is split among workers.
 
 /// @brief Handle index.
 /// @note Order is crucial to WaitForMultipleObjects(). Do not touch.
@@ -79,12 +186,19 @@ typedef enum th_handles {
     AUDIO_PROD_THREAD_HNDLE,
     VIDEO_THREAD_HNDLE,
     VIDEO_PROD_THREAD_HNDLE,
+    VIDEO_READ_THREAD_HNDLE,
+    VIDEO_WRITE_THREAD_HNDLE,
 } th_handles;
 
-/// @brief Event handle index.
+/// @brief Event handle index. One auto-reset wake event per thread.
+/// @note Audio events come first, only those are created when there is no video.
 typedef enum ev_handles {
+    AUDIO_EVENT_WAKE_HNDLE,
     AUDIO_PROD_EVENT_WAKE_HNDLE,
+    VIDEO_EVENT_WAKE_HNDLE,
     VIDEO_PROD_EVENT_WAKE_HNDLE,
+    VIDEO_READ_EVENT_WAKE_HNDLE,
+    VIDEO_WRITE_EVENT_WAKE_HNDLE,
 } ev_handles;
 
 /// @brief Key codes.
@@ -100,6 +214,7 @@ typedef enum key_code {
     G,         // Debug print.
     D,         // Switch dithering modes.
     R,         // Switch color modes.
+    H,         // Dot hysteresis.
     Q          // Shutdown.
 } key_code;
 
@@ -112,10 +227,54 @@ typedef enum dither_mode {
     DTH_BAYER_8X8,
     DTH_BAYER_4X4,
     DTH_SIERRA_LITE,
+    DTH_ATKINSON,
+    DTH_STUCKI,
+    DTH_JJN,
+    DTH_BURKES,
+    DTH_DOT_DIFFUSION,
+    DTH_BLOCK_DIFFUSION,
+    DTH_PATTERN,
     DTH_THRESHOLDING,
     DTH_MODES
 } dither_mode;
 
+/// @brief Error diffusion kernels. (Mode, function, name, divisor, weights)
+/// Weights are `DIFFUSION_ROWS` rows of `DIFFUSION_COLS`: the pixel's own row, then those below,
+/// from `DIFFUSION_REACH` pixels left of it to as many right. On its own row, only those right of
+/// it apply. They're laid out for rows scanned left to right, and mirrored for the others.
+/// Floyd-Steinberg and Sierra Lite are modified. Floyd-Steinberg splits the lower 9/16 evenly,
+/// Sierra Lite keeps all of the error, half right and half to the bottom left.
+#define DIFFUSION_LIST                                                                             \
+    X(DTH_FLOYD_STEINBERG, flyd_stnbrg, "FLOYD-STEINBERG", 16,                                     \
+      0, 0, 0, 7, 0,                                                                               \
+      0, 3, 3, 3, 0,                                                                               \
+      0, 0, 0, 0, 0)                                                                               \
+    X(DTH_SIERRA_LITE, sierra_lite, "SIERRA-LITE", 2,                                              \
+      0, 0, 0, 1, 0,                                                                               \
+      0, 1, 0, 0, 0,                                                                               \
+      0, 0, 0, 0, 0)                                                                               \
+    X(DTH_ATKINSON, atkinson, "ATKINSON", 8,                                                       \
+      0, 0, 0, 1, 1,                                                                               \
+      0, 1, 1, 1, 0,                                                                               \
+      0, 0, 1, 0, 0)                                                                               \
+    X(DTH_STUCKI, stucki, "STUCKI", 42,                                                            \
+      0, 0, 0, 8, 4,                                                                               \
+      2, 4, 8, 4, 2,                                                                               \
+      1, 2, 4, 2, 1)                                                                               \
+    X(DTH_JJN, jjn, "JARVIS-JUDICE-NINKE", 48,                                                     \
+      0, 0, 0, 7, 5,                                                                               \
+      3, 5, 7, 5, 3,                                                                               \
+      1, 3, 5, 3, 1)                                                                               \
+    X(DTH_BURKES, burkes, "BURKES", 32,                                                            \
+      0, 0, 0, 8, 4,                                                                               \
+      2, 4, 8, 4, 2,                                                                               \
+      0, 0, 0, 0, 0)
+
+#define DIFFUSION_ROWS 3
+#define DIFFUSION_COLS 5
+#define DIFFUSION_REACH 2 // Pixels either side a kernel reaches.
+#define DIFFUSION_TAPS (DIFFUSION_ROWS * DIFFUSION_COLS)
+
 typedef enum color_mode {
     CLM_DARK_BLUE = 0b0001,
     CLM_DARK_GREEN = 0b0010,
@@ -141,6 +300,9 @@ typedef struct media_mtdta {
     double duration;
     size_t height;
     size_t width;
+    UINT   fps_num; // Source frame rate, as a fraction. (`r_frame_rate`, else `avg_frame_rate`)
+    UINT   fps_den;
+    double fps;
     bool   video_present;
     bool   audio_present;
 } media_mtdta;
@@ -150,10 +312,15 @@ typedef enum thread_id {
     AUDIO_THREAD_ID,
     AUDIO_PROD_THREAD_ID,
     VIDEO_THREAD_ID,
-    VIDEO_PROD_THREAD_ID
+    VIDEO_PROD_THREAD_ID,
+    VIDEO_READ_THREAD_ID,
+    VIDEO_WRITE_THREAD_ID
 } thread_id;
 
-typedef struct player player;
+typedef struct player        player;
+typedef struct spsc_ring     spsc_ring;
+typedef struct task_pool     task_pool;
+typedef struct frame_mailbox frame_mailbox;
 
 /// @brief Thread data to be passed at creation.
 typedef struct thread_data {
@@ -161,33 +328,98 @@ typedef struct thread_data {
     thread_id thread_id;
 } thread_data;
 
-/// @brief Player.
-typedef struct player {
-    con_frame     **video_rbuffer;
-    s16_le         *audio_rbuffer;
-    char           *gwpvbuffer; // Work buffer. VProducer.
-    char           *gwcvbuffer; // Work buffer. VConsumer.
+/// @brief What a producer waits on. Used with `serial_changed()`.
+typedef struct serial_watch {
+    player *pl;
+    size_t  serial; // Serial the producer is working on.
+} serial_watch;
+
+/// @brief Control state. Only written by the input thread, inside `begin_ctrl_write()` and
+/// `end_ctrl_write()`. Fields can be read on their own, use `get_ctrl_snapshot()` when more than
+/// one has to agree with the others.
+typedef struct player_ctrl {
+    atomic_size_t   seq; // Seqlock sequence. Odd while a write is in progress.
     atomic_bool_t   shutdown;
     atomic_bool_t   playing;
     atomic_bool_t   looping;
-    atomic_bool_t   invalidated; // Any disruptive operation. (Seeking, console resizing)
+    atomic_bool_t   invalidated; // Any disruptive operation. (Seeking)
     atomic_bool_t   muted;
     atomic_bool_t   debug_print;
-    atomic_double_t main_clock;
+    atomic_bool_t   stable_dots; // Temporal hysteresis on dots.
     atomic_double_t volume;
     atomic_double_t seek_speed;
     atomic_size_t   dither_mode;
     atomic_size_t   color_mode;
-    atomic_size_t   serial; // Data versioning.
-    atomic_size_t   aread_idx;
-    atomic_size_t   awrite_idx;
-    atomic_size_t   vread_idx;
-    atomic_size_t   vwrite_idx;
-    atomic_size_t   ext_assets_ptr; // Extra data such as textures for dithering.
-    DWORD           active_threads;
-    HANDLE         *th_hndles; // Use with `th_handles`.
-    HANDLE         *ev_hndles; // Use with `ev_handles`.
-    thread_data   **th_data;   // Use with `th_handle_idx`.
-    media_mtdta    *media_mtdta;
+    atomic_size_t   serial;        // Data versioning.
+    atomic_size_t   layout;        // Console layout generation. Bumped on resize.
+    atomic_size_t   output_target; // Output bandwidth to stay under, in bytes/s. 0 for none.
+} player_ctrl;
+
+/// @brief Consistent copy of the control state. The main clock isn't part of it, the audio callback
+/// moves it outside of the seqlock. See `get_main_clock()`.
+typedef struct ctrl_snapshot {
+    bool        shutdown;
+    bool        playing;
+    bool        looping;
+    bool        invalidated;
+    bool        muted;
+    bool        debug_print;
+    bool        stable_dots;
+    double      volume;
+    double      seek_speed;
+    dither_mode dither_mode;
+    color_mode  color_mode;
+    size_t      serial;
+    size_t      layout;
+} ctrl_snapshot;
+
+/// @brief Player.
+/// @note Shared state is grouped by the thread that writes it, one cache line per group, so that
+/// a write from one thread doesn't invalidate what the others are polling.
+/// Allocated with `_aligned_malloc()` to keep the alignment.
+typedef struct player {
+    // Set up by `create_player()`, read-only afterwards.
+    spsc_ring     *video_ring; // Holds `con_frame*`s.
+    spsc_ring     *audio_ring; // Holds `s16_le` samples.
+    spsc_ring     *raw_ring;   // Holds decoded `dec_frame*`s. VReader to VProducer.
+    spsc_ring     *raw_free;   // Holds free `dec_frame*`s. VProducer back to VReader.
+    dec_frame     *raw_pool;   // `VRAW_FRAMES` frames, cycled through the two rings above.
+    task_pool     *pool;       // Shared compute pool. Outlives every player thread.
+    frame_mailbox *mailbox;    // Console frames. VConsumer to VWriter.
+    uint8_t       *blue_tile;  // Blue noise tile, shared by every dithering context.
+    char          *gwpvbuffer; // Work buffer. VProducer.
+    char          *gwcvbuffer; // Work buffer. VConsumer.
+    DWORD          active_threads;
+    HANDLE        *th_hndles; // Use with `th_handles`.
+    HANDLE        *ev_hndles; // Use with `ev_handles`.
+    thread_data  **th_data;   // Use with `th_handle_idx`.
+    media_mtdta   *media_mtdta;
+
+    // Input thread.
+    _Alignas(CACHE_LINE_BSIZE) player_ctrl ctrl;
+
+    // Audio callback. Seeks also write here, both under `srw_mclock`, which readers share.
+    _Alignas(CACHE_LINE_BSIZE) atomic_double_t main_clock;
+    atomic_double_t clock_stamp; // `mono_time()` of the last clock advance.
+    atomic_double_t clock_step;  // Size of the last clock advance. 0 while the clock is held.
     SRWLOCK         srw_mclock;
+
+    // Video consumer.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t last_fhash; // Grid hash of the last presented frame.
+    atomic_size_t skipped_frames;  // Decoded, but passed over for a newer frame that was due.
+    atomic_size_t replaced_frames; // Posted, but replaced before the writer got to them.
+    atomic_size_t still_frames;    // Not repainted, as they (nearly) match what's on screen.
+
+    // Video writer.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t output_level; // Output governor's `output_level`.
+    atomic_double_t output_bps;    // Output bandwidth in use. Informational.
+    atomic_double_t write_s;       // Average frame write time. Informational.
+    atomic_double_t write_latency; // Average time from post to written. Informational.
+
+    // Video producer.
+    _Alignas(CACHE_LINE_BSIZE) atomic_size_t culled_frames; // Decoded, but too late to render.
+    atomic_size_t   quality_level; // Governor's `quality_level`. Informational.
+    atomic_double_t render_load;   // Governor's load. Informational.
+    atomic_double_t render_reuse;  // Average share of cells reused. Informational.
+    atomic_double_t changed_cells; // Average cells changed per frame. Informational.
 } player;
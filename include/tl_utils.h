@@ -21,71 +21,87 @@
         }                                                                                          \
     } while (0)
 
-/// @brief For byte reinterpretation.
-union double_l64 {
-    double d;
-    LONG64 l64;
-};
-
-/// @brief Sets an atomic bool to a given value.
-/// @param b Target atomic variable.
-/// @param value Value to set to.
-void set_atomic_bool(
-    atomic_bool_t *b,
-    bool           value
+/// @brief Opens a control state write. Readers retry until the matching `end_ctrl_write()`.
+/// @param pl Player struct.
+/// @note Only the input thread writes control state. Writes do not nest.
+void begin_ctrl_write(player *pl);
+
+/// @brief Closes a control state write, publishing every change made since `begin_ctrl_write()`.
+/// Wakes every thread so that blocked threads see the change.
+/// @param pl Player struct.
+void end_ctrl_write(player *pl);
+
+/// @brief Takes a consistent copy of the control state and the main clock.
+/// @param pl Player struct.
+/// @param out Out-parameter to hold the snapshot.
+void get_ctrl_snapshot(
+    player        *pl,
+    ctrl_snapshot *out
 );
 
-/// @brief Gets the value held by an atomic bool.
-/// @param b Target atomic variable.
-/// @return Value of variable.
-bool get_atomic_bool(atomic_bool_t *b);
-
-/// @brief Flips an atomic bool. Internally uses a XOR flip.
-/// @param b Target atomic variable
-void flip_atomic_bool(atomic_bool_t *b);
-
-/// @brief Sets an atomic double to a given value.
-/// @param dbl Target atomic variable.
-/// @param value Value to set to.
-void set_atomic_double(
-    atomic_double_t *dbl,
-    double           value
+/// @brief Wakes a thread blocked in `wait_for_wake()`. The wake is kept if it isn't waiting yet.
+/// @param pl Player struct.
+/// @param ev Wake event of the target thread.
+void signal_wake(
+    player          *pl,
+    const ev_handles ev
 );
 
-/// @brief Gets the value held by an atomic double.
-/// @param dbl Target atomic variable.
-/// @return Value of variable.
-double get_atomic_double(atomic_double_t *dbl);
-
-/// @brief Adds a given value to a target atomic double.
-/// @param dbl Target atomic double.
-/// @param addend Value to be added to variable.
-void add_atomic_double(
-    atomic_double_t *dbl,
-    double           addend
+/// @brief Wakes every thread. Done on every control state change.
+/// @param pl Player struct.
+void wake_threads(player *pl);
+
+/// @brief Blocks the calling thread until its wake event is signaled.
+/// @param pl Player struct.
+/// @param ev Wake event of the calling thread.
+/// @param timeout_ms Timeout in milliseconds, or `INFINITE`.
+/// @note Wakes can be spurious, callers re-check their condition afterwards.
+void wait_for_wake(
+    player          *pl,
+    const ev_handles ev,
+    const DWORD      timeout_ms
 );
 
-/// @brief Sets an atomic size_t to a given value.
-/// @param st Target atomic variable.
-/// @param value Value to be set to.
-void set_atomic_size_t(
-    atomic_size_t *st,
-    size_t         value
+/// @brief Blocks the calling thread until its wake event is signaled or the delay has passed.
+/// @param pl Player struct.
+/// @param ev Wake event of the calling thread.
+/// @param timer Waitable timer owned by the calling thread.
+/// @param delay_s Delay in seconds.
+/// @note Meant for waits shorter than the scheduler tick, which `wait_for_wake()` rounds up.
+void wait_for_deadline(
+    player          *pl,
+    const ev_handles ev,
+    HANDLE           timer,
+    const double     delay_s
 );
 
-/// @brief Gets the value held by an atomic size_t.
-/// @param st Target atomic variable.
-/// @return Value of variable.
-size_t get_atomic_size_t(atomic_size_t* st);
-
-/// @brief Adds a value to a target atomic size_t.
-/// @param st Target atomic variable.
-/// @param addend Value to be added to the variable.
-void add_atomic_size_t(
-    atomic_size_t *st,
-    size_t         addend
+/// @brief Creates a waitable timer, high resolution where the system supports it.
+/// @return Timer handle or NULL.
+HANDLE create_deadline_timer(void);
+
+/// @brief Monotonic time. (`QueryPerformanceCounter()`)
+/// @return Time in seconds since an unspecified point.
+double mono_time(void);
+
+/// @brief Reads the main clock, under `srw_mclock`.
+/// @param pl Player struct.
+/// @return Clock in seconds.
+double get_main_clock(player *pl);
+
+/// @brief Main clock extrapolated to the current moment.
+/// @param pl Player struct.
+/// @param snap Snapshot to take the playing state from.
+/// @return Clock in seconds. Never ahead of where the next clock advance will put it.
+double get_present_clock(
+    player              *pl,
+    const ctrl_snapshot *snap
 );
 
+/// @brief Cancellation check for blocking ring operations. (`spsc_cancel_fn`)
+/// @param watch `serial_watch*`.
+/// @return True on shutdown or once the serial has moved past the watched one.
+bool serial_changed(void *watch);
+
 /// @brief Creates and allocates a `media_mtdta` to a NULL-ed out-parameter.
 /// @param media_path Path to the media file.
 /// @param out Out-parameter to hold created metadata.
@@ -112,6 +128,8 @@ tl_result vpthread_exec(thread_data *data);
 tl_result vcthread_exec(thread_data *data);
 tl_result apthread_exec(thread_data *data);
 tl_result acthread_exec(thread_data *data);
+tl_result vrthread_exec(thread_data *data);
+tl_result vwthread_exec(thread_data *data);
 
 /// @brief Thread dispatcher function.
 /// @param data Thread data.
@@ -127,6 +145,11 @@ tl_result create_player(
     player     **out
 );
 
+/// @brief Creates and allocates a `frame_codec` to a NULL-ed out-parameter.
+/// @param out Out-parameter to hold created codec.
+/// @return Return code.
+tl_result create_frame_codec(frame_codec **out);
+
 /// @brief Copies a raw frame to a specified destination.
 /// @param src Source raw frame.
 /// @param dst_out Destination of the copy.
@@ -155,7 +178,11 @@ void destroy_conframe(con_frame **frame_ptr);
 /// @param frame_ptr Address of pointer to frame struct.
 void destroy_rawframe(raw_frame **frame_ptr);
 
-/// @brief Prints playback information to console.
+/// @brief Corresponding destroy function to free struct.
+/// @param codec_ptr Address of pointer to codec.
+void destroy_frame_codec(frame_codec **codec_ptr);
+
+/// @brief Prints playback information to console. With video, hands it to the writer instead.
 /// @param pl Player struct.
 void playback_stats(player *pl);
 
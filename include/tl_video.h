@@ -11,4 +11,14 @@ tl_result vpthread_exec(thread_data *data);
 /// @brief Starts producer video thread execution.
 /// @param data Thread data.
 /// @return Thread exit code.
-tl_result vcthread_exec(thread_data *data);
\ No newline at end of file
+tl_result vcthread_exec(thread_data *data);
+
+/// @brief Starts reader video thread execution.
+/// @param data Thread data.
+/// @return Thread exit code.
+tl_result vrthread_exec(thread_data *data);
+
+/// @brief Starts writer video thread execution.
+/// @param data Thread data.
+/// @return Thread exit code.
+tl_result vwthread_exec(thread_data *data);
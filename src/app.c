@@ -9,9 +9,17 @@ tl_result player_exec(
     const WCHAR **wargv
 ) {
     tl_result excv = TL_SUCCESS;
-    CHECK(excv, argc != 2, TL_INVALID_ARG, return excv);
+    CHECK(excv, argc != 2 && argc != 3, TL_INVALID_ARG, return excv);
     CHECK(excv, wargv == NULL, TL_NULL_ARG, return excv);
 
+    // Optional output bandwidth target, in KB/s.
+    size_t output_target = 0;
+    if (argc == 3) {
+        WCHAR *end = NULL;
+        output_target = (size_t)wcstoul(wargv[2], &end, 10) * 1000;
+        CHECK(excv, end == wargv[2] || *end != L'\0', TL_INVALID_ARG, return excv);
+    }
+
     DWORD attr = GetFileAttributesW(wargv[1]);
     CHECK(excv, attr == INVALID_FILE_ATTRIBUTES, TL_INVALID_FILE, return excv);
 
@@ -24,13 +32,16 @@ tl_result player_exec(
     will happen especially with old Bluetooth devices.
     */
 
-    set_atomic_bool(&pl->looping, true);
-    set_atomic_bool(&pl->playing, true);
-    set_atomic_double(&pl->volume, 0.5);
+    begin_ctrl_write(pl);
+    set_atomic_bool(&pl->ctrl.looping, true);
+    set_atomic_bool(&pl->ctrl.playing, true);
+    set_atomic_double(&pl->ctrl.volume, 0.5);
+    set_atomic_size_t(&pl->ctrl.output_target, output_target);
+    end_ctrl_write(pl);
 
     DWORD th_excv = 0;
     while (true) {
-        if (get_atomic_bool(&pl->shutdown)) {
+        if (get_atomic_bool(&pl->ctrl.shutdown)) {
             break;
         }
         key_code key = NO_INPUT;
@@ -86,6 +97,9 @@ void get_input(key_code *kc) {
         case 'r':
             *kc = R;
             break;
+        case 'h':
+            *kc = H;
+            break;
         default:
             *kc = NO_INPUT;
             break;
@@ -147,127 +161,149 @@ tl_result process_input(
         new_csbi.srWindow.Top != set_csbi.srWindow.Top ||
         new_csbi.srWindow.Left != set_csbi.srWindow.Left ||
         new_csbi.srWindow.Right != set_csbi.srWindow.Right) {
-        set_atomic_bool(&pl->invalidated, true);
-        add_atomic_size_t(&pl->serial, 1);
+        // Video is rescaled in-process. Decoders keep running, playback isn't interrupted.
+        begin_ctrl_write(pl);
+        add_atomic_size_t(&pl->ctrl.layout, 1);
+        end_ctrl_write(pl);
         set_csbi = new_csbi;
         return TL_SUCCESS;
     }
 
-    AcquireSRWLockExclusive(&pl->srw_mclock);
-
     // We can't seek beyond the end without possibly raising errors, so we cut it a bit short
-    // (~50ms)
-    if (get_atomic_double(&pl->main_clock) > pl->media_mtdta->duration - POLLING_RATE_S) {
-        if (get_atomic_bool(&pl->looping)) {
-            set_atomic_bool(&pl->invalidated, true);
-            set_atomic_double(&pl->main_clock, 0.0);
+    // (~50ms). The clock is set apart from the control write, before the serial that makes
+    // producers restart from it, so snapshot readers never wait on its lock.
+    const bool looping = get_atomic_bool(&pl->ctrl.looping);
+    AcquireSRWLockExclusive(&pl->srw_mclock);
+    const bool at_end =
+        get_atomic_double(&pl->main_clock) > pl->media_mtdta->duration - POLLING_RATE_S;
+    if (at_end && looping) {
+        set_atomic_double(&pl->main_clock, 0.0);
+    }
+    ReleaseSRWLockExclusive(&pl->srw_mclock);
+    if (at_end) {
+        begin_ctrl_write(pl);
+        if (looping) {
+            set_atomic_bool(&pl->ctrl.invalidated, true);
         } else {
-            set_atomic_bool(&pl->shutdown, true);
+            set_atomic_bool(&pl->ctrl.shutdown, true);
         }
-        add_atomic_size_t(&pl->serial, 1);
+        add_atomic_size_t(&pl->ctrl.serial, 1);
+        end_ctrl_write(pl);
     }
-    ReleaseSRWLockExclusive(&pl->srw_mclock);
-    if (get_atomic_bool(&pl->shutdown)) {
+    if (get_atomic_bool(&pl->ctrl.shutdown)) {
         return excv;
     }
-    if (!get_atomic_bool(&pl->debug_print)) {
+    if (!get_atomic_bool(&pl->ctrl.debug_print)) {
         playback_stats(pl);
     }
+    if (kc == NO_INPUT && get_atomic_double(&pl->ctrl.seek_speed) == 0.0 &&
+        !get_atomic_bool(&pl->ctrl.invalidated)) {
+        // Nothing to reset. Skipping the write keeps idle threads asleep.
+        seek_length_s = 0.0;
+        if (get_atomic_bool(&pl->ctrl.debug_print)) {
+            state_print(pl);
+        }
+        return excv;
+    }
+    // Seeks move the clock by the speed so far, ahead of the control write for the same reason.
+    if (kc == ARR_LEFT || kc == ARR_RIGHT) {
+        const double seek_speed = get_atomic_double(&pl->ctrl.seek_speed);
+        AcquireSRWLockExclusive(&pl->srw_mclock);
+        if (kc == ARR_RIGHT) {
+            add_atomic_double(&pl->main_clock, seek_speed);
+        } else if (get_atomic_double(&pl->main_clock) - seek_speed > 0.0) {
+            add_atomic_double(&pl->main_clock, -seek_speed);
+        } else {
+            set_atomic_double(&pl->main_clock, 0.0);
+        }
+        ReleaseSRWLockExclusive(&pl->srw_mclock);
+    }
+    bool refresh_stats = false;
+    begin_ctrl_write(pl);
     switch (kc) {
     case Q:
-        set_atomic_bool(&pl->shutdown, true);
+        set_atomic_bool(&pl->ctrl.shutdown, true);
         break;
     case SPACE:
-        flip_atomic_bool(&pl->playing);
+        flip_atomic_bool(&pl->ctrl.playing);
         break;
     case M:
-        flip_atomic_bool(&pl->muted);
+        flip_atomic_bool(&pl->ctrl.muted);
         break;
     case L:
-        flip_atomic_bool(&pl->looping);
+        flip_atomic_bool(&pl->ctrl.looping);
         break;
     case ARR_UP:
         set_atomic_double(
-            &pl->volume, get_atomic_double(&pl->volume) + 0.02 < 1.01
-                             ? get_atomic_double(&pl->volume) + 0.02
+            &pl->ctrl.volume, get_atomic_double(&pl->ctrl.volume) + 0.02 < 1.01
+                             ? get_atomic_double(&pl->ctrl.volume) + 0.02
                              : 1.0
         );
-        if (!get_atomic_bool(&pl->debug_print)) {
-            playback_stats(pl);
-        }
+        refresh_stats = true;
         break;
     case ARR_DOWN:
         set_atomic_double(
-            &pl->volume, get_atomic_double(&pl->volume) - 0.02 > -0.01
-                             ? get_atomic_double(&pl->volume) - 0.02
+            &pl->ctrl.volume, get_atomic_double(&pl->ctrl.volume) - 0.02 > -0.01
+                             ? get_atomic_double(&pl->ctrl.volume) - 0.02
                              : 0.0
         );
-        if (!get_atomic_bool(&pl->debug_print)) {
-            playback_stats(pl);
-        }
+        refresh_stats = true;
         break;
     case ARR_LEFT:
         spdl_unbounded = 1.8 * pow(2, seek_length_s);
-        AcquireSRWLockExclusive(&pl->srw_mclock);
-        set_atomic_bool(&pl->invalidated, true);
-        const double ssl = get_atomic_double(&pl->seek_speed);
-        if (ssl == 0.0) {
-            add_atomic_size_t(&pl->serial, 1);
-        }
-        set_atomic_double(&pl->seek_speed, spdl_unbounded > 480.0 ? 480.0 : spdl_unbounded);
-        if (get_atomic_double(&pl->main_clock) - ssl > 0.0) {
-            add_atomic_double(&pl->main_clock, -ssl);
-        } else {
-            set_atomic_double(&pl->main_clock, 0.0);
-        }
-        ReleaseSRWLockExclusive(&pl->srw_mclock);
-        if (!get_atomic_bool(&pl->debug_print)) {
-            playback_stats(pl);
+        set_atomic_bool(&pl->ctrl.invalidated, true);
+        if (get_atomic_double(&pl->ctrl.seek_speed) == 0.0) {
+            add_atomic_size_t(&pl->ctrl.serial, 1);
         }
+        set_atomic_double(&pl->ctrl.seek_speed, spdl_unbounded > 480.0 ? 480.0 : spdl_unbounded);
+        refresh_stats = true;
         seek_length_s += POLLING_RATE_S;
         break;
     case ARR_RIGHT:
         spdr_unbounded = 1.8 * pow(2, seek_length_s);
-        AcquireSRWLockExclusive(&pl->srw_mclock);
-        set_atomic_bool(&pl->invalidated, true);
-        const double ssr = get_atomic_double(&pl->seek_speed);
-        if (ssr == 0.0) {
-            add_atomic_size_t(&pl->serial, 1);
-        }
-        set_atomic_double(&pl->seek_speed, spdr_unbounded > 480.0 ? 480.0 : spdr_unbounded);
-        add_atomic_double(&pl->main_clock, ssr);
-        ReleaseSRWLockExclusive(&pl->srw_mclock);
-        if (!get_atomic_bool(&pl->debug_print)) {
-            playback_stats(pl);
+        set_atomic_bool(&pl->ctrl.invalidated, true);
+        if (get_atomic_double(&pl->ctrl.seek_speed) == 0.0) {
+            add_atomic_size_t(&pl->ctrl.serial, 1);
         }
+        set_atomic_double(&pl->ctrl.seek_speed, spdr_unbounded > 480.0 ? 480.0 : spdr_unbounded);
+        refresh_stats = true;
         seek_length_s += POLLING_RATE_S;
         break;
     case G:
-        flip_atomic_bool(&pl->debug_print);
+        flip_atomic_bool(&pl->ctrl.debug_print);
+        break;
+    case H:
+        flip_atomic_bool(&pl->ctrl.stable_dots);
         break;
     case D:
-        const size_t dth_cmode = get_atomic_size_t(&pl->dither_mode);
+        const size_t dth_cmode = get_atomic_size_t(&pl->ctrl.dither_mode);
         if (dth_cmode == DTH_MODES - 1) {
-            set_atomic_size_t(&pl->dither_mode, 0);
+            set_atomic_size_t(&pl->ctrl.dither_mode, 0);
         } else {
-            add_atomic_size_t(&pl->dither_mode, 1);
+            add_atomic_size_t(&pl->ctrl.dither_mode, 1);
         }
         break;
     case R:
-        const size_t clr_cmode = get_atomic_size_t(&pl->color_mode);
+        const size_t clr_cmode = get_atomic_size_t(&pl->ctrl.color_mode);
         if (clr_cmode == 1) {
-            set_atomic_size_t(&pl->color_mode, CLM_WHITE);
+            set_atomic_size_t(&pl->ctrl.color_mode, CLM_WHITE);
         } else {
              const int8_t clr_nmode = (int8_t)clr_cmode - 1;
-             set_atomic_size_t(&pl->color_mode, clr_nmode);
+             set_atomic_size_t(&pl->ctrl.color_mode, clr_nmode);
         }
     case NO_INPUT:
-        set_atomic_double(&pl->seek_speed, 0.0);
-        set_atomic_bool(&pl->invalidated, false);
+        set_atomic_double(&pl->ctrl.seek_speed, 0.0);
+        set_atomic_bool(&pl->ctrl.invalidated, false);
         seek_length_s = 0.0;
         break;
     }
-    if (get_atomic_bool(&pl->debug_print)) {
+    end_ctrl_write(pl);
+
+    // Stats are read through a snapshot, which waits for the write above to close.
+    if (refresh_stats && !get_atomic_bool(&pl->ctrl.debug_print)) {
+        playback_stats(pl);
+    }
+    if (get_atomic_bool(&pl->ctrl.debug_print)) {
         state_print(pl);
     }
     return excv;
@@ -1,6 +1,7 @@
 #include "tl_audio.h"
 #include "tl_errors.h"
 #include "tl_pch.h"
+#include "tl_ring.h"
 #include "tl_types.h"
 #include "tl_utils.h"
 
@@ -21,27 +22,25 @@ tl_result apthread_exec(thread_data *data) {
     tl_result excv = TL_SUCCESS;
     CHECK(excv, data == NULL, TL_NULL_ARG, return excv);
     player             *pl = data->player;
-    size_t              set_serial = 0;
+    serial_watch        watch = {.pl = pl, .serial = 0};
     double              prod_aclock = 0.0;
     s16_le              staging_buffer[GLBUFFER_BSIZE];
     static const size_t staging_scount = sizeof(staging_buffer) / sizeof(s16_le);
-    static const size_t abuffer_scount = ABUFFER_BSIZE / sizeof(s16_le);
     FILE               *ffmpeg_stream = NULL;
-    
+
     while (true) {
-        if (get_atomic_bool(&pl->shutdown)) {
+        if (get_atomic_bool(&pl->ctrl.shutdown)) {
             break;
         }
-        if (get_atomic_size_t(&pl->serial) != set_serial) {
+        if (get_atomic_size_t(&pl->ctrl.serial) != watch.serial) {
             if (ffmpeg_stream != NULL) {
                 _pclose(ffmpeg_stream);
                 ffmpeg_stream = NULL;
             }
-            set_serial = get_atomic_size_t(&pl->serial);
-            set_atomic_size_t(&pl->aread_idx, 0);
-            set_atomic_size_t(&pl->awrite_idx, 0);
-            while (get_atomic_bool(&pl->invalidated)) {
-                Sleep(5);
+            watch.serial = get_atomic_size_t(&pl->ctrl.serial);
+            spsc_mark(pl->audio_ring, watch.serial);
+            while (get_atomic_bool(&pl->ctrl.invalidated) && !get_atomic_bool(&pl->ctrl.shutdown)) {
+                wait_for_wake(pl, AUDIO_PROD_EVENT_WAKE_HNDLE, INFINITE);
             }
             prod_aclock = get_atomic_double(&pl->main_clock);
         }
@@ -52,8 +51,7 @@ tl_result apthread_exec(thread_data *data) {
             goto epilogue);
 
         while (true) {
-            if (feof(ffmpeg_stream) || get_atomic_size_t(&pl->serial) != set_serial ||
-                get_atomic_bool(&pl->shutdown)) {
+            if (feof(ffmpeg_stream) || serial_changed(&watch)) {
                 break;
             }
             size_t f_ret = fread(staging_buffer, sizeof(s16_le), staging_scount, ffmpeg_stream);
@@ -62,27 +60,15 @@ tl_result apthread_exec(thread_data *data) {
             if (f_ret != staging_scount) {
                 memset(staging_buffer + f_ret, 0, (staging_scount - f_ret) * sizeof(s16_le));
             }
-            for (size_t j = 0; j < staging_scount; ++j) {
-                const size_t nwrite_idx = (get_atomic_size_t(&pl->awrite_idx) + 1) % abuffer_scount;
-                while (nwrite_idx == get_atomic_size_t(&pl->aread_idx)) {
-                    if (get_atomic_size_t(&pl->serial) != set_serial ||
-                        get_atomic_bool(&pl->shutdown)) {
-                        break;
-                    }
-                    Sleep(10);
-                }
-                if (get_atomic_size_t(&pl->serial) != set_serial ||
-                    get_atomic_bool(&pl->shutdown)) {
-                    break;
-                }
-                pl->audio_rbuffer[get_atomic_size_t(&pl->awrite_idx)] = staging_buffer[j];
-                set_atomic_size_t(&pl->awrite_idx, nwrite_idx);
+            if (!spsc_push_wait(
+                    pl->audio_ring, staging_buffer, staging_scount, serial_changed, &watch
+                )) {
+                break;
             }
         }
         if (feof(ffmpeg_stream)) {
-            while (!get_atomic_bool(&pl->shutdown) &&
-                   get_atomic_size_t(&pl->serial) == set_serial) {
-                Sleep(1);
+            while (!serial_changed(&watch)) {
+                wait_for_wake(pl, AUDIO_PROD_EVENT_WAKE_HNDLE, INFINITE);
             }
         }
         _pclose(ffmpeg_stream);
@@ -135,10 +121,10 @@ tl_result acthread_exec(thread_data *data) {
     ma_result devr = ma_device_start(&adevice);
     CHECK(excv, devr != MA_SUCCESS, TL_MINIAUDIO_ERR, goto epilogue);
     while (true) {
-        if (get_atomic_bool(&pl->shutdown)) {
+        if (get_atomic_bool(&pl->ctrl.shutdown)) {
             break;
         }
-        Sleep(100);
+        wait_for_wake(pl, AUDIO_EVENT_WAKE_HNDLE, INFINITE);
     }
 epilogue:
     ma_device_uninit(&adevice);
@@ -151,63 +137,49 @@ static void audio_callback(
     const void *pInput,
     ma_uint32   frameCount
 ) {
-    thread_data        *data = (thread_data *)pDevice->pUserData;
-    player             *pl = data->player;
-    size_t              samples_required = frameCount * A_CHANNELS;
-    static size_t       set_serial = 0;
-    static const size_t buffer_samples = ABUFFER_BSIZE / sizeof(s16_le);
+    thread_data *data = (thread_data *)pDevice->pUserData;
+    player      *pl = data->player;
+    size_t       samples_required = frameCount * A_CHANNELS;
 
-    set_serial = get_atomic_size_t(&pl->serial);
-    const bool   shutdown = get_atomic_bool(&pl->shutdown);
-    const bool   muted = get_atomic_bool(&pl->muted);
-    const bool   invalidated = get_atomic_bool(&pl->invalidated);
-    const bool   playback = get_atomic_bool(&pl->playing);
-    const size_t current_serial = get_atomic_size_t(&pl->serial);
-    const double volume = get_atomic_double(&pl->volume);
+    ctrl_snapshot snap;
+    get_ctrl_snapshot(pl, &snap);
+    const bool   shutdown = snap.shutdown;
+    const bool   muted = snap.muted;
+    const bool   invalidated = snap.invalidated;
+    const bool   playback = snap.playing;
+    const size_t current_serial = snap.serial;
+    const double volume = snap.volume;
 
-    if (shutdown || muted || invalidated || !playback || set_serial != current_serial) {
+    if (shutdown || invalidated || !playback) {
+        set_atomic_double(&pl->clock_step, 0.0);
         memset(pOutput, 0, samples_required * sizeof(s16_le));
-        if (set_serial != current_serial) {
-            set_serial = current_serial;
-            return;
-        }
-        if (!playback || invalidated || shutdown) {
-            return;
-        }
+        return;
     }
 
-    const size_t set_read = get_atomic_size_t(&pl->aread_idx);
-    const size_t new_read = (set_read + samples_required) % (buffer_samples);
-    const size_t set_write = get_atomic_size_t(&pl->awrite_idx);
-    const size_t valid_samples = (set_write + (buffer_samples)-set_read) % (buffer_samples);
-
-    if (valid_samples < samples_required) {
+    // The clock only moves on once the producer has caught up after a seek.
+    if (!spsc_flush(pl->audio_ring, current_serial) ||
+        spsc_size(pl->audio_ring) < samples_required) {
+        set_atomic_double(&pl->clock_step, 0.0);
         memset(pOutput, 0, samples_required * sizeof(s16_le));
         return;
     }
-    if (!muted && playback && !invalidated && !shutdown && valid_samples >= samples_required) {
-        if (set_read + samples_required < (buffer_samples)) {
-            memcpy(pOutput, &pl->audio_rbuffer[set_read], samples_required * sizeof(s16_le));
-        } else {
-            const size_t diff = samples_required - (buffer_samples - set_read);
-            memcpy(
-                pOutput, &pl->audio_rbuffer[set_read], (buffer_samples - set_read) * sizeof(s16_le)
-            );
-            memcpy(
-                (s16_le *)pOutput + (buffer_samples - set_read), &pl->audio_rbuffer,
-                diff * sizeof(s16_le)
-            );
-        }
+
+    // Popping wakes the producer. Muted output still consumes to keep the clock moving.
+    spsc_pop(pl->audio_ring, pOutput, samples_required);
+    if (muted) {
+        memset(pOutput, 0, samples_required * sizeof(s16_le));
+    } else {
         for (size_t i = 0; i < samples_required; ++i) {
             ((s16_le *)pOutput)[i] = (s16_le)((double)((s16_le *)pOutput)[i] * volume);
         }
     }
-    if (valid_samples >= samples_required) {
-        set_atomic_size_t(&pl->aread_idx, new_read);
-    }
 
-    // Only one other writer. Near-zero contention.
+    // Only one other writer. Near-zero contention. The stamp and step go with the clock, they let
+    // the video consumer extrapolate between callbacks.
+    const double step = (double)frameCount / (double)A_SAMP_RATE;
     AcquireSRWLockExclusive(&pl->srw_mclock);
-    add_atomic_double(&pl->main_clock, (double)frameCount / (double)A_SAMP_RATE);
+    add_atomic_double(&pl->main_clock, step);
+    set_atomic_double(&pl->clock_stamp, mono_time());
+    set_atomic_double(&pl->clock_step, step);
     ReleaseSRWLockExclusive(&pl->srw_mclock);
 }
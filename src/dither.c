@@ -0,0 +1,1094 @@
+#include "tl_dither.h"
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+static tl_result dither_rect(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    raw_frame        *rframe,
+    const cell_rect  *rect
+);
+
+// Position of each tiled byte within its cell. Inverse of `tiled_dot_idx()`.
+static const uint8_t tiled_dot_x[BRAILLE_DOTS_PER_CHAR] = {0, 0, 0, 1, 1, 1, 0, 1};
+static const uint8_t tiled_dot_y[BRAILLE_DOTS_PER_CHAR] = {0, 1, 2, 0, 1, 2, 3, 3};
+
+/// @brief Rearranges a row-major block of pixels into the tiled layout.
+static void tile_pixels(
+    const uint8_t *src,
+    const size_t   wdth,
+    const size_t   ln,
+    uint8_t       *dst
+) {
+    const size_t cell_wdth = wdth / BRAILLE_CHAR_DOT_WDTH;
+    for (size_t y = 0; y < ln; ++y) {
+        for (size_t x = 0; x < wdth; ++x) {
+            dst[tiled_px_idx(cell_wdth, x, y)] = src[y * wdth + x];
+        }
+    }
+}
+
+void pack_braille(
+    const raw_frame *rframe,
+    uint8_t         *cells
+) {
+    const cell_rect all = {
+        .col = 0,
+        .row = 0,
+        .wdth = rframe->fwidth / BRAILLE_CHAR_DOT_WDTH,
+        .ln = rframe->flength / BRAILLE_CHAR_DOT_LN
+    };
+    pack_braille_rect(rframe, &all, cells);
+}
+
+void pack_braille_rect(
+    const raw_frame *rframe,
+    const cell_rect *rect,
+    uint8_t         *cells
+) {
+    // Multiplying the masked top bits by `gather` moves the top bit of byte `k` to bit `56 + k`.
+    static const uint64_t top_bits = 0x8080808080808080ULL;
+    static const uint64_t gather = 0x0002040810204081ULL;
+    const size_t          cell_wdth = rframe->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    uint64_t              dots = 0;
+
+    // Top bit set is the same as >= 128. Byte `k` is the low byte of a cell on little-endian.
+    for (size_t cy = rect->row; cy < rect->row + rect->ln; ++cy) {
+        const size_t   first = cy * cell_wdth + rect->col;
+        const uint8_t *px = rframe->data + first * BRAILLE_DOTS_PER_CHAR;
+        for (size_t i = 0; i < rect->wdth; ++i) {
+            memcpy(&dots, px + i * BRAILLE_DOTS_PER_CHAR, sizeof(dots));
+            cells[first + i] = (uint8_t)(((dots & top_bits) * gather) >> 56);
+        }
+    }
+}
+
+uint64_t hash_cells(
+    const uint8_t *cells,
+    const size_t   count
+) {
+    static const uint64_t fnv_offset = 0xcbf29ce484222325ULL;
+    static const uint64_t fnv_prime = 0x100000001b3ULL;
+    uint64_t              hash = fnv_offset;
+
+    // Hashes code points rather than masks so hashes stay comparable with the glyph grids of
+    // earlier builds.
+    for (size_t i = 0; i < count; ++i) {
+        hash ^= (uint64_t)(BRAILLE_BASE_CODEPOINT | cells[i]);
+        hash *= fnv_prime;
+    }
+    return hash;
+}
+
+/// @brief Offsets that hold a cell's dots as they were. Set dots get pushed up by the margin, the
+/// others down, so a dot only flips once its pixel crosses the threshold by more than that.
+/// @param prev Dots of the previous frame. NULL leaves every offset at 0.
+/// @param cell Cell index.
+/// @param bias Out-parameter, one offset per tiled byte.
+static void hyst_bias(
+    const uint8_t *prev,
+    const size_t   cell,
+    int16_t        bias[BRAILLE_DOTS_PER_CHAR]
+) {
+    for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+        bias[k] = prev == NULL ? 0 : (prev[cell] >> k) & 1 ? DTH_HYST_MARGIN : -DTH_HYST_MARGIN;
+    }
+}
+
+/// @brief Thresholds a tiled frame against a tiled square matrix repeated over it.
+/// @param rect Cells to threshold. The matrix stays anchored to the frame.
+/// @param side Matrix side. A power of two and a multiple of `BRAILLE_CHAR_DOT_LN`.
+/// @param black_on_equal Whether pixels equal to their threshold turn black.
+/// @param prev Dots of the previous frame to hold with hysteresis. Can be NULL.
+static void ordered_dither(
+    raw_frame       *rf,
+    const cell_rect *rect,
+    const uint8_t   *tiled,
+    const size_t     side,
+    const bool       black_on_equal,
+    const uint8_t   *prev
+) {
+    const size_t m_cell_wdth = side / BRAILLE_CHAR_DOT_WDTH;
+    const size_t m_cell_ln = side / BRAILLE_CHAR_DOT_LN;
+    const size_t cell_wdth = rf->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    int16_t      bias[BRAILLE_DOTS_PER_CHAR];
+    for (size_t cy = rect->row; cy < rect->row + rect->ln; ++cy) {
+        const uint8_t *m_row = tiled + (cy & (m_cell_ln - 1)) * m_cell_wdth * BRAILLE_DOTS_PER_CHAR;
+        uint8_t       *px = rf->data + (cy * cell_wdth + rect->col) * BRAILLE_DOTS_PER_CHAR;
+        for (size_t cx = rect->col; cx < rect->col + rect->wdth; ++cx) {
+            const uint8_t *t = m_row + (cx & (m_cell_wdth - 1)) * BRAILLE_DOTS_PER_CHAR;
+            hyst_bias(prev, cy * cell_wdth + cx, bias);
+            for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+                const int16_t value = px[k] + bias[k];
+                const bool    black = black_on_equal ? t[k] >= value : t[k] > value;
+                px[k] = black ? 0 : 255;
+            }
+            px += BRAILLE_DOTS_PER_CHAR;
+        }
+    }
+}
+
+/// @brief Returns a threshold matrix tiled, tiling it into the context on first use.
+static const uint8_t *tiled_matrix(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    const uint8_t    *matrix,
+    const size_t      side
+) {
+    if (!ctx->matrix_set[dmode]) {
+        tile_pixels(matrix, side, side, ctx->matrices[dmode]);
+        ctx->matrix_set[dmode] = true;
+    }
+    return ctx->matrices[dmode];
+}
+
+static tl_result threshold(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    // No-op. Thresholding is handled by the converter instead (<128 & >=128).
+    if (ctx->prev_masks == NULL) {
+        return TL_SUCCESS;
+    }
+
+    // Unless dots are held, then it's done here, against the same threshold.
+    const size_t cell_wdth = rf->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    int16_t      bias[BRAILLE_DOTS_PER_CHAR];
+    for (size_t cy = rect->row; cy < rect->row + rect->ln; ++cy) {
+        uint8_t *px = rf->data + (cy * cell_wdth + rect->col) * BRAILLE_DOTS_PER_CHAR;
+        for (size_t cx = rect->col; cx < rect->col + rect->wdth; ++cx) {
+            hyst_bias(ctx->prev_masks, cy * cell_wdth + cx, bias);
+            for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+                px[k] = px[k] + bias[k] < 128 ? 0 : 255;
+            }
+            px += BRAILLE_DOTS_PER_CHAR;
+        }
+    }
+    return TL_SUCCESS;
+}
+
+/// @brief Returns the context's error buffer, grown to hold at least `count` slots and zeroed.
+static tl_result err_buffer(
+    dither_ctx   *ctx,
+    const size_t  count,
+    int16_t     **out
+) {
+    tl_result excv = TL_SUCCESS;
+    if (ctx->err_count < count) {
+        free(ctx->err_buf);
+        ctx->err_count = 0;
+        ctx->err_buf = malloc(count * sizeof(int16_t));
+        CHECK(excv, ctx->err_buf == NULL, TL_ALLOC_FAILURE, return excv);
+        ctx->err_count = count;
+    }
+    memset(ctx->err_buf, 0, count * sizeof(int16_t));
+    *out = ctx->err_buf;
+    return excv;
+}
+
+/// @brief Runs `fn` on items `0` to `count - 1`, over the context's pool if it has one.
+static void split_items(
+    dither_ctx       *ctx,
+    const size_t      count,
+    const pool_for_fn fn,
+    void             *arg
+) {
+    if (ctx->pool != NULL) {
+        pool_parallel_for(ctx->pool, count, fn, arg);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        fn(arg, i);
+    }
+}
+
+/// @brief Diffuses the error of one row, scanning in `step` direction. Edge pixels need no
+/// checks, the error rows are padded by `DIFFUSION_REACH` on both sides and that error is dropped.
+/// @param rows Error rows, this one first, in units of 1/`div`.
+static inline void diffuse_row(
+    raw_frame      *rf,
+    const size_t    y,
+    int16_t *const  rows[DIFFUSION_ROWS],
+    const int8_t    weights[DIFFUSION_TAPS],
+    const int16_t   div,
+    const ptrdiff_t step
+) {
+    const size_t wdth = rf->fwidth;
+    const size_t cell_wdth = wdth / BRAILLE_CHAR_DOT_WDTH;
+    for (size_t i = 0; i < wdth; ++i) {
+        const size_t x = step > 0 ? i : wdth - 1 - i;
+        uint8_t     *px = rf->data + tiled_px_idx(cell_wdth, x, y);
+
+        // Quantizing leaves at most 128 either way. A slot sums no more than `div` times that,
+        // which int16 holds for every kernel.
+        const int16_t value = (int16_t)(*px + rows[0][x + DIFFUSION_REACH] / div);
+        const uint8_t out = value < 128 ? 0 : 255;
+        const int16_t delta = (int16_t)(value - out);
+        *px = out;
+        for (size_t r = 0; r < DIFFUSION_ROWS; ++r) {
+            int16_t *err = rows[r] + x + DIFFUSION_REACH;
+            for (size_t c = 0; c < DIFFUSION_COLS; ++c) {
+                const ptrdiff_t dx = ((ptrdiff_t)c - DIFFUSION_REACH) * step;
+                err[dx] = (int16_t)(err[dx] + weights[r * DIFFUSION_COLS + c] * delta);
+            }
+        }
+    }
+}
+
+/// @brief Error diffusion over a whole tiled frame, scanned serpentine. Inlined into one
+/// function per kernel in `DIFFUSION_LIST`, so the weights are constants, taps of 0 drop out and
+/// the tap loops unroll.
+static inline tl_result diffuse(
+    dither_ctx   *ctx,
+    raw_frame    *rf,
+    const int8_t  weights[DIFFUSION_TAPS],
+    const int16_t div
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, ctx == NULL || rf == NULL, TL_NULL_ARG, return excv);
+    const size_t stride = rf->fwidth + 2 * DIFFUSION_REACH;
+    int16_t     *err = NULL;
+    TRY(excv, err_buffer(ctx, DIFFUSION_ROWS * stride, &err), return excv);
+    int16_t *rows[DIFFUSION_ROWS];
+    for (size_t r = 0; r < DIFFUSION_ROWS; ++r) {
+        rows[r] = err + r * stride;
+    }
+    for (size_t y = 0; y < rf->flength; ++y) {
+        if (y & 1) {
+            diffuse_row(rf, y, rows, weights, div, -1);
+        } else {
+            diffuse_row(rf, y, rows, weights, div, 1);
+        }
+
+        // The row done with becomes the last one below, emptied.
+        int16_t *done = rows[0];
+        for (size_t r = 0; r + 1 < DIFFUSION_ROWS; ++r) {
+            rows[r] = rows[r + 1];
+        }
+        memset(done, 0, stride * sizeof(int16_t));
+        rows[DIFFUSION_ROWS - 1] = done;
+    }
+    return excv;
+}
+
+// One function per kernel.
+#define X(dmode, fn, str, div, ...)                                                                \
+    static tl_result fn(                                                                           \
+        dither_ctx      *ctx,                                                                      \
+        raw_frame       *rf,                                                                       \
+        const cell_rect *rect                                                                      \
+    ) {                                                                                            \
+        static const int8_t weights[DIFFUSION_TAPS] = {__VA_ARGS__};                               \
+        return diffuse(ctx, rf, weights, div);                                                     \
+    }
+DIFFUSION_LIST
+#undef X
+
+// Copied blocks of cells have to line up with whole dot diffusion blocks.
+_Static_assert(
+    CHG_BLOCK_CELL_WDTH * BRAILLE_CHAR_DOT_WDTH % DOT_CLASS_SIDE == 0 &&
+        CHG_BLOCK_CELL_LN * BRAILLE_CHAR_DOT_LN % DOT_CLASS_SIDE == 0,
+    "Change detection blocks must be made of dot diffusion blocks."
+);
+
+// Knuth, 1987. Within a block, pixels are quantized in class order and pass their error on to
+// neighbors of higher classes. Only the few with none left (barons) drop it.
+static const uint8_t dot_classes[DOT_CLASS_SIDE * DOT_CLASS_SIDE] = {
+    34, 48, 40, 32, 29, 15, 23, 31, 42, 58, 56, 53, 21, 5,  7,  10, 50, 62, 61, 45, 13, 1,
+    2,  18, 38, 46, 54, 37, 25, 17, 9,  26, 28, 14, 22, 30, 35, 49, 41, 33, 20, 4,  6,  11,
+    43, 59, 57, 52, 12, 0,  3,  19, 51, 63, 60, 44, 24, 16, 8,  27, 39, 47, 55, 36
+};
+
+// Position of every class within a block. Inverse of `dot_classes`.
+static const uint8_t dot_order[DOT_CLASS_SIDE * DOT_CLASS_SIDE] = {
+    49, 21, 22, 50, 41, 13, 42, 14, 58, 30, 15, 43, 48, 20, 33, 5,  57, 29, 23, 51, 40, 12,
+    34, 6,  56, 28, 31, 59, 32, 4,  35, 7,  3,  39, 0,  36, 63, 27, 24, 60, 2,  38, 8,  44,
+    55, 19, 25, 61, 1,  37, 16, 52, 47, 11, 26, 62, 10, 46, 9,  45, 54, 18, 17, 53
+};
+
+/// @brief Rect of a frame to dot-diffuse, in whole blocks but for the frame's edges.
+typedef struct dot_frame {
+    raw_frame *rf;
+    size_t     first_x;
+    size_t     end_x;
+    size_t     first_y;
+} dot_frame;
+
+/// @brief Weight a pixel's error goes to a neighbor with, 0 if it goes nowhere. Orthogonal
+/// neighbors get twice what diagonal ones do. Only higher classes within the block get any.
+static inline int dot_weight(
+    const size_t    bx,
+    const size_t    by,
+    const ptrdiff_t dx,
+    const ptrdiff_t dy,
+    const size_t    wdth,
+    const size_t    ln,
+    const size_t    cls
+) {
+    const size_t nx = bx + dx;
+    const size_t ny = by + dy;
+    if ((dx == 0 && dy == 0) || nx >= wdth || ny >= ln ||
+        dot_classes[ny * DOT_CLASS_SIDE + nx] <= cls) {
+        return 0;
+    }
+    return dx == 0 || dy == 0 ? 2 : 1;
+}
+
+/// @brief Dot-diffuses a row of blocks. (`pool_for_fn`) Error never leaves its block, so blocks
+/// don't depend on each other, or on anything outside the rect.
+static void dot_row(
+    void        *arg,
+    const size_t item
+) {
+    const dot_frame *df = (const dot_frame *)arg;
+    raw_frame       *rf = df->rf;
+    const size_t     cell_wdth = rf->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    const size_t     y0 = df->first_y + item * DOT_CLASS_SIDE;
+    const size_t     rows_left = rf->flength - y0;
+    const size_t     ln = rows_left < DOT_CLASS_SIDE ? rows_left : DOT_CLASS_SIDE;
+    for (size_t x0 = df->first_x; x0 < df->end_x; x0 += DOT_CLASS_SIDE) {
+        const size_t cols_left = rf->fwidth - x0;
+        const size_t wdth = cols_left < DOT_CLASS_SIDE ? cols_left : DOT_CLASS_SIDE;
+        int          err[DOT_CLASS_SIDE * DOT_CLASS_SIDE] = {0};
+        for (size_t cls = 0; cls < DOT_CLASS_SIDE * DOT_CLASS_SIDE; ++cls) {
+            const size_t bx = dot_order[cls] % DOT_CLASS_SIDE;
+            const size_t by = dot_order[cls] / DOT_CLASS_SIDE;
+            if (bx >= wdth || by >= ln) {
+                continue;
+            }
+            uint8_t  *px = rf->data + tiled_px_idx(cell_wdth, x0 + bx, y0 + by);
+            const int value = *px + err[dot_order[cls]];
+            const int delta = value < 128 ? value : value - UINT8_MAX;
+            *px = value < 128 ? 0 : UINT8_MAX;
+            int total = 0;
+            for (ptrdiff_t dy = -1; dy <= 1; ++dy) {
+                for (ptrdiff_t dx = -1; dx <= 1; ++dx) {
+                    total += dot_weight(bx, by, dx, dy, wdth, ln, cls);
+                }
+            }
+            for (ptrdiff_t dy = -1; dy <= 1 && total > 0; ++dy) {
+                for (ptrdiff_t dx = -1; dx <= 1; ++dx) {
+                    const int weight = dot_weight(bx, by, dx, dy, wdth, ln, cls);
+                    if (weight > 0) {
+                        err[(by + dy) * DOT_CLASS_SIDE + bx + dx] += delta * weight / total;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static tl_result dot_dth(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, ctx == NULL || rf == NULL, TL_NULL_ARG, return excv);
+    if (rect->wdth == 0 || rect->ln == 0) {
+        return excv;
+    }
+
+    // Blocks stay anchored to the frame, like the ordered matrices.
+    const size_t first_y = rect->row * BRAILLE_CHAR_DOT_LN / DOT_CLASS_SIDE * DOT_CLASS_SIDE;
+    const size_t end_y = (rect->row + rect->ln) * BRAILLE_CHAR_DOT_LN;
+
+    dot_frame df = {
+        .rf = rf,
+        .first_x = rect->col * BRAILLE_CHAR_DOT_WDTH / DOT_CLASS_SIDE * DOT_CLASS_SIDE,
+        .end_x = (rect->col + rect->wdth) * BRAILLE_CHAR_DOT_WDTH,
+        .first_y = first_y
+    };
+    split_items(ctx, (end_y - first_y + DOT_CLASS_SIDE - 1) / DOT_CLASS_SIDE, dot_row, &df);
+    return excv;
+}
+
+/// @brief One step of block error diffusion: the tiles on one diagonal of the wavefront.
+typedef struct tile_wave {
+    raw_frame *rf;
+    int16_t   *err; // One slot per pixel, row-major, in 1/16ths.
+    size_t     tiles_x;
+    size_t     step;
+    size_t     first_ty;
+} tile_wave;
+
+/// @brief Floyd-Steinberg over one tile of the step. (`pool_for_fn`) Error that leaves the tile
+/// waits in `err` for the tiles right and below, which come in later steps.
+static void diffuse_tile(
+    void        *arg,
+    const size_t item
+) {
+    const tile_wave *wave = (const tile_wave *)arg;
+    raw_frame       *rf = wave->rf;
+    const size_t     wdth = rf->fwidth;
+    const size_t     ln = rf->flength;
+    const size_t     cell_wdth = wdth / BRAILLE_CHAR_DOT_WDTH;
+    const size_t     ty = wave->first_ty + item;
+    const size_t     x0 = (wave->step - 2 * ty) * BLOCK_DIFF_SIDE;
+    const size_t     y0 = ty * BLOCK_DIFF_SIDE;
+    const size_t     x1 = x0 + BLOCK_DIFF_SIDE < wdth ? x0 + BLOCK_DIFF_SIDE : wdth;
+    const size_t     y1 = y0 + BLOCK_DIFF_SIDE < ln ? y0 + BLOCK_DIFF_SIDE : ln;
+    for (size_t y = y0; y < y1; ++y) {
+        for (size_t x = x0; x < x1; ++x) {
+            uint8_t      *px = rf->data + tiled_px_idx(cell_wdth, x, y);
+            int16_t      *err = wave->err + y * wdth + x;
+            const int16_t value = (int16_t)(*px + *err / 16);
+            const uint8_t out = value < 128 ? 0 : 255;
+            const int16_t delta = (int16_t)(value - out);
+            *px = out;
+            if (x + 1 < wdth) {
+                err[1] = (int16_t)(err[1] + 7 * delta);
+            }
+            if (y + 1 == ln) {
+                continue;
+            }
+            if (x > 0) {
+                err[wdth - 1] = (int16_t)(err[wdth - 1] + 3 * delta);
+            }
+            err[wdth] = (int16_t)(err[wdth] + 5 * delta);
+            if (x + 1 < wdth) {
+                err[wdth + 1] = (int16_t)(err[wdth + 1] + delta);
+            }
+        }
+    }
+}
+
+/// Tiles get error from the tiles left, above, and above on either side. Tile (x, y) goes in step
+/// x + 2y, after all of those, and every tile of a step runs at once. Tiles of the same step
+/// never write the same pixels: the only tile two of them both reach, they reach at opposite
+/// edges. The order is fixed, so the output doesn't depend on how the steps get split.
+static tl_result block_dth(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, ctx == NULL || rf == NULL, TL_NULL_ARG, return excv);
+    (void)rect;
+    if (rf->fwidth == 0 || rf->flength == 0) {
+        return excv;
+    }
+    tile_wave wave = {.rf = rf, .err = NULL, .step = 0, .first_ty = 0};
+    TRY(excv, err_buffer(ctx, rf->fwidth * rf->flength, &wave.err), return excv);
+    wave.tiles_x = (rf->fwidth + BLOCK_DIFF_SIDE - 1) / BLOCK_DIFF_SIDE;
+    const size_t tiles_y = (rf->flength + BLOCK_DIFF_SIDE - 1) / BLOCK_DIFF_SIDE;
+    const size_t steps = wave.tiles_x + 2 * (tiles_y - 1);
+    for (wave.step = 0; wave.step < steps; ++wave.step) {
+        // Tiles of the step with x in range, from the lowest y up.
+        const size_t past_x = wave.step + 1 > wave.tiles_x ? wave.step + 1 - wave.tiles_x : 0;
+        const size_t last_ty = wave.step / 2 < tiles_y - 1 ? wave.step / 2 : tiles_y - 1;
+        wave.first_ty = (past_x + 1) / 2;
+        if (wave.first_ty <= last_ty) {
+            split_items(ctx, last_ty - wave.first_ty + 1, diffuse_tile, &wave);
+        }
+    }
+    return excv;
+}
+
+/// @brief Blurs a cell within itself, down to 7 bits, so that patterns and cells compare on tone
+/// as well as on shape. A pixel becomes the weighted mean of itself and its neighbors in the cell.
+static inline void blur_cell(
+    const uint16_t weights[BRAILLE_DOTS_PER_CHAR * BRAILLE_DOTS_PER_CHAR],
+    const uint8_t  px[BRAILLE_DOTS_PER_CHAR],
+    uint8_t        out[BRAILLE_DOTS_PER_CHAR]
+) {
+    for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+        const uint16_t *w = weights + k * BRAILLE_DOTS_PER_CHAR;
+        uint32_t        sum = 0;
+        for (size_t j = 0; j < BRAILLE_DOTS_PER_CHAR; ++j) {
+            sum += w[j] * px[j];
+        }
+        out[k] = (uint8_t)(sum >> 9);
+    }
+}
+
+/// @brief Pattern with the least summed difference to a blurred cell, out of all of them.
+static inline uint8_t best_pattern(
+    const uint8_t *patterns,
+    const uint8_t  blurred[BRAILLE_DOTS_PER_CHAR]
+) {
+    const __m128i cell = _mm_loadl_epi64((const __m128i *)blurred);
+    const __m128i cells = _mm_unpacklo_epi64(cell, cell);
+
+    // Eight patterns per step. Lane `j` keeps the least difference of patterns `8 * step + j`,
+    // shifted up past the step it came from. Differences stay within 10 bits, so both fit 15.
+    __m128i best = _mm_set1_epi16(INT16_MAX);
+    for (int step = 0; step < BRAILLE_PATTERNS / 8; ++step) {
+        const __m128i *p = (const __m128i *)(patterns + step * 8 * BRAILLE_DOTS_PER_CHAR);
+        const __m128i  sad01 = _mm_sad_epu8(cells, _mm_loadu_si128(p));
+        const __m128i  sad23 = _mm_sad_epu8(cells, _mm_loadu_si128(p + 1));
+        const __m128i  sad45 = _mm_sad_epu8(cells, _mm_loadu_si128(p + 2));
+        const __m128i  sad67 = _mm_sad_epu8(cells, _mm_loadu_si128(p + 3));
+        const __m128i  sads = _mm_packs_epi32(
+            _mm_packs_epi32(sad01, sad23), _mm_packs_epi32(sad45, sad67)
+        );
+        const __m128i keys = _mm_or_si128(_mm_slli_epi16(sads, 5), _mm_set1_epi16((short)step));
+        best = _mm_min_epi16(best, keys);
+    }
+    int16_t keys[8];
+    _mm_storeu_si128((__m128i *)keys, best);
+    size_t lane = 0;
+    for (size_t j = 1; j < 8; ++j) {
+        lane = keys[j] < keys[lane] ? j : lane;
+    }
+    return (uint8_t)((keys[lane] & 31) * 8 + lane);
+}
+
+/// @brief Blurs every pattern into the context, once. A pixel weighs 4 to itself, 2 to the
+/// pixels next to it and 1 to those diagonal to it, in 1/256ths of their sum. Flat cells get
+/// their matches looked up, they're most of a frame.
+static void build_patterns(dither_ctx *ctx) {
+    if (ctx->patterns_set) {
+        return;
+    }
+    for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+        uint32_t raw[BRAILLE_DOTS_PER_CHAR];
+        uint32_t total = 0;
+        for (size_t j = 0; j < BRAILLE_DOTS_PER_CHAR; ++j) {
+            const size_t dx = tiled_dot_x[k] > tiled_dot_x[j] ? tiled_dot_x[k] - tiled_dot_x[j]
+                                                              : tiled_dot_x[j] - tiled_dot_x[k];
+            const size_t dy = tiled_dot_y[k] > tiled_dot_y[j] ? tiled_dot_y[k] - tiled_dot_y[j]
+                                                              : tiled_dot_y[j] - tiled_dot_y[k];
+            raw[j] = dx > 1 || dy > 1 ? 0 : 4u >> (dx + dy);
+            total += raw[j];
+        }
+
+        // Rounding down keeps every sum within 8 bits, and so every blurred pixel within 7.
+        for (size_t j = 0; j < BRAILLE_DOTS_PER_CHAR; ++j) {
+            ctx->blur_weights[k * BRAILLE_DOTS_PER_CHAR + j] = (uint16_t)(raw[j] * 256 / total);
+        }
+    }
+    for (size_t mask = 0; mask < BRAILLE_PATTERNS; ++mask) {
+        uint8_t px[BRAILLE_DOTS_PER_CHAR];
+        for (size_t j = 0; j < BRAILLE_DOTS_PER_CHAR; ++j) {
+            px[j] = (mask >> j) & 1 ? UINT8_MAX : 0;
+        }
+        blur_cell(ctx->blur_weights, px, ctx->patterns + mask * BRAILLE_DOTS_PER_CHAR);
+    }
+    for (size_t luma = 0; luma <= UINT8_MAX; ++luma) {
+        uint8_t px[BRAILLE_DOTS_PER_CHAR];
+        uint8_t blurred[BRAILLE_DOTS_PER_CHAR];
+        memset(px, (int)luma, sizeof(px));
+        blur_cell(ctx->blur_weights, px, blurred);
+        ctx->flat_masks[luma] = best_pattern(ctx->patterns, blurred);
+    }
+    ctx->patterns_set = true;
+}
+
+/// @brief Rows of cells to pattern-match. (`pool_for_fn` argument)
+typedef struct ptn_rows {
+    const dither_ctx *ctx;
+    raw_frame        *rf;
+    const cell_rect  *rect;
+} ptn_rows;
+
+/// @brief Matches `DTH_SPLIT_CELL_LN` rows of cells. (`pool_for_fn`) Cells don't depend on each
+/// other.
+static void match_rows(
+    void        *arg,
+    const size_t item
+) {
+    const ptn_rows  *pr = (const ptn_rows *)arg;
+    const cell_rect *rect = pr->rect;
+    const size_t     cell_wdth = pr->rf->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    const size_t     first = rect->row + item * DTH_SPLIT_CELL_LN;
+    const size_t     rows_left = rect->row + rect->ln - first;
+    const size_t     end = first + (rows_left < DTH_SPLIT_CELL_LN ? rows_left : DTH_SPLIT_CELL_LN);
+    for (size_t cy = first; cy < end; ++cy) {
+        uint8_t *px = pr->rf->data + (cy * cell_wdth + rect->col) * BRAILLE_DOTS_PER_CHAR;
+        for (size_t cx = 0; cx < rect->wdth; ++cx) {
+            // Cells holding an edge get stretched to full contrast, so faint strokes come out
+            // whole. The others keep their tone.
+            uint8_t lo = UINT8_MAX;
+            uint8_t hi = 0;
+            for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+                lo = px[k] < lo ? px[k] : lo;
+                hi = px[k] > hi ? px[k] : hi;
+            }
+            const bool     edge = hi - lo >= PTN_EDGE_RANGE;
+            const uint32_t scale = edge ? (UINT8_MAX << 16) / (hi - lo) : 0;
+            uint8_t        stretched[BRAILLE_DOTS_PER_CHAR];
+            uint8_t        blurred[BRAILLE_DOTS_PER_CHAR];
+            uint8_t        mask = pr->ctx->flat_masks[(lo + hi) / 2];
+            for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR && edge; ++k) {
+                stretched[k] = (uint8_t)(((uint32_t)(px[k] - lo) * scale) >> 16);
+            }
+            if (hi - lo >= PTN_FLAT_RANGE) {
+                blur_cell(pr->ctx->blur_weights, edge ? stretched : px, blurred);
+                mask = best_pattern(pr->ctx->patterns, blurred);
+            }
+            for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+                px[k] = (mask >> k) & 1 ? UINT8_MAX : 0;
+            }
+            px += BRAILLE_DOTS_PER_CHAR;
+        }
+    }
+}
+
+/// Every cell gets the pattern that looks most like it. Plain differences would pick the
+/// thresholded cell every time, blurring both sides first lets a gray cell match a pattern of the
+/// same tone, while a cell that already looks like a pattern still matches it exactly.
+static tl_result pattern_dth(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, ctx == NULL || rf == NULL, TL_NULL_ARG, return excv);
+    build_patterns(ctx);
+    ptn_rows pr = {.ctx = ctx, .rf = rf, .rect = rect};
+    split_items(ctx, (rect->ln + DTH_SPLIT_CELL_LN - 1) / DTH_SPLIT_CELL_LN, match_rows, &pr);
+    return excv;
+}
+
+static tl_result blue_dth(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    static const size_t threshold[DTH_BLUE_MODES] = {V_FPS - 8, V_FPS - 15, V_FPS - 23, 0};
+    tl_result           excv = TL_SUCCESS;
+    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, ctx == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, ctx->blue_tile == NULL, TL_DEP_NOT_FOUND, return excv);
+
+    // A cycle a second of video, counted in `V_FPS` ticks like the thresholds. Going by time
+    // rather than frames keeps it steady across source rates and dropped frames.
+    const double tick = (ctx->pts - floor(ctx->pts)) * V_FPS;
+    size_t       mode = 0;
+    for (size_t i = 0; i < DTH_BLUE_MODES && !ctx->stable; ++i) {
+        if ((double)threshold[i] > tick) {
+            mode++;
+            continue;
+        }
+        break;
+    }
+
+    // Every mode mirrors the tile differently. Whole cells are mirrored, then the dots in them.
+    const bool   flip_x = mode == 1 || mode == 2;
+    const bool   flip_y = mode == 1 || mode == 3;
+    const size_t cell_wdth = rf->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    const size_t t_cell_mask_x = BNOISE_SIDE / BRAILLE_CHAR_DOT_WDTH - 1;
+    const size_t t_cell_mask_y = BNOISE_SIDE / BRAILLE_CHAR_DOT_LN - 1;
+    size_t       src_dot[BRAILLE_DOTS_PER_CHAR];
+    int16_t      bias[BRAILLE_DOTS_PER_CHAR];
+    for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+        src_dot[k] = tiled_dot_idx(
+            flip_x ? BRAILLE_CHAR_DOT_WDTH - 1 - tiled_dot_x[k] : tiled_dot_x[k],
+            flip_y ? BRAILLE_CHAR_DOT_LN - 1 - tiled_dot_y[k] : tiled_dot_y[k]
+        );
+    }
+
+    // The tile repeats over the frame, anchored to it like the ordered matrices.
+    for (size_t cy = rect->row; cy < rect->row + rect->ln; ++cy) {
+        const size_t   t_cy = flip_y ? t_cell_mask_y - (cy & t_cell_mask_y) : cy & t_cell_mask_y;
+        const uint8_t *t_row = ctx->blue_tile + t_cy * (t_cell_mask_x + 1) * BRAILLE_DOTS_PER_CHAR;
+        uint8_t       *px = rf->data + (cy * cell_wdth + rect->col) * BRAILLE_DOTS_PER_CHAR;
+        for (size_t cx = rect->col; cx < rect->col + rect->wdth; ++cx) {
+            const size_t   t_cx = cx & t_cell_mask_x;
+            const uint8_t *t =
+                t_row + (flip_x ? t_cell_mask_x - t_cx : t_cx) * BRAILLE_DOTS_PER_CHAR;
+            hyst_bias(ctx->prev_masks, cy * cell_wdth + cx, bias);
+            for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+                px[k] = px[k] + bias[k] > t[src_dot[k]] ? UINT8_MAX : 0;
+            }
+            px += BRAILLE_DOTS_PER_CHAR;
+        }
+    }
+    return excv;
+}
+
+static tl_result halftone(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
+
+    // We use a spiral pattern dither here.
+    static const uint8_t matrix[HALFTONE_MATRIX_SIZE] = {
+        (uint8_t)(255 * 10 / (double)16), (uint8_t)(255 * 9 / (double)16),
+        (uint8_t)(255 * 8 / (double)16),  (uint8_t)(255 * 7 / (double)16),
+        (uint8_t)(255 * 11 / (double)16), (uint8_t)(255 * 16 / (double)16),
+        (uint8_t)(255 * 15 / (double)16), (uint8_t)(255 * 6 / (double)16),
+        (uint8_t)(255 * 12 / (double)16), (uint8_t)(255 * 13 / (double)16),
+        (uint8_t)(255 * 14 / (double)16), (uint8_t)(255 * 5 / (double)16),
+        (uint8_t)(255 * 1 / (double)16),  (uint8_t)(255 * 2 / (double)16),
+        (uint8_t)(255 * 3 / (double)16),  (uint8_t)(255 * 4 / (double)16)
+    };
+    ordered_dither(rf, rect, tiled_matrix(ctx, DTH_HALFTONE, matrix, 4), 4, false, ctx->prev_masks);
+    return TL_SUCCESS;
+}
+
+static tl_result bayer_4x4(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
+
+    // The mathematical bayer matrix was supposed to have 0 at the first entry (0, 0)
+    // but I changed it to have a threshold of 1 for aesthetic purposes allowing for deep blacks.
+    static const uint8_t matrix[BAYER_4X4_MATRIX_SIZE] = {15, 127, 31, 159, 191, 63,  223, 95,
+                                                          47, 175, 15, 143, 239, 111, 207, 79};
+
+    ordered_dither(
+        rf, rect, tiled_matrix(ctx, DTH_BAYER_4X4, matrix, 4), 4, false, ctx->prev_masks
+    );
+    return TL_SUCCESS;
+}
+
+static tl_result bayer_8x8(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
+
+    // The mathematical bayer matrix was supposed to have 0
+    // but I changed it to have a threshold of 1 for aesthetic purposes allowing for deep blacks.
+    static const uint8_t matrix[BAYER_8X8_MATRIX_SIZE] = {
+        3,  127, 31, 159, 7,  135, 39, 167, 191, 63,  223, 95,  199, 71,  231, 103,
+        47, 175, 15, 143, 55, 183, 23, 151, 239, 111, 207, 79,  247, 119, 215, 87,
+        11, 139, 43, 171, 3,  131, 35, 163, 203, 75,  235, 107, 195, 67,  227, 99,
+        59, 187, 27, 155, 51, 179, 19, 147, 251, 123, 219, 91,  243, 115, 211, 83
+    };
+
+    ordered_dither(
+        rf, rect, tiled_matrix(ctx, DTH_BAYER_8X8, matrix, 8), 8, false, ctx->prev_masks
+    );
+    return TL_SUCCESS;
+}
+
+static tl_result bayer_16x16(
+    dither_ctx      *ctx,
+    raw_frame       *rf,
+    const cell_rect *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
+
+    // The mathematical bayer matrix was supposed to have 0
+    // but I changed it to have a threshold of 1 for aesthetic purposes allowing for deep blacks.
+    static const uint8_t matrix[BAYER_16X16_MATRIX_SIZE] = {
+        0,   128, 32,  160, 8,   136, 40,  168, 2,   130, 34,  162, 10,  138, 42,  170, 192, 64,
+        224, 96,  200, 72,  232, 104, 194, 66,  226, 98,  202, 74,  234, 106, 48,  176, 16,  144,
+        56,  184, 24,  152, 50,  178, 18,  146, 58,  186, 26,  154, 240, 112, 208, 80,  248, 120,
+        216, 88,  242, 114, 210, 82,  250, 122, 218, 90,  12,  140, 44,  172, 4,   132, 36,  164,
+        14,  142, 46,  174, 6,   134, 38,  166, 204, 76,  236, 108, 196, 68,  228, 100, 206, 78,
+        238, 110, 198, 70,  230, 102, 60,  188, 28,  156, 52,  180, 20,  148, 62,  190, 30,  158,
+        54,  182, 22,  150, 252, 124, 220, 92,  244, 116, 212, 84,  254, 126, 222, 94,  246, 118,
+        214, 86,  3,   131, 35,  163, 11,  139, 43,  171, 1,   129, 33,  161, 9,   137, 41,  169,
+        195, 67,  227, 99,  203, 75,  235, 107, 197, 69,  229, 101, 205, 77,  237, 109, 51,  179,
+        19,  147, 59,  187, 27,  155, 49,  177, 17,  145, 57,  185, 25,  153, 243, 115, 211, 83,
+        251, 123, 219, 91,  241, 113, 209, 81,  249, 121, 217, 89,  15,  143, 47,  175, 7,   135,
+        39,  167, 13,  141, 45,  173, 5,   133, 37,  165, 207, 79,  239, 111, 199, 71,  231, 103,
+        209, 81,  241, 113, 201, 73,  233, 105, 63,  191, 31,  159, 55,  183, 23,  151, 61,  189,
+        29,  157, 53,  181, 21,  149, 255, 127, 223, 95,  247, 119, 215, 87,  253, 125, 221, 93,
+        245, 117, 213, 85
+    };
+    ordered_dither(
+        rf, rect, tiled_matrix(ctx, DTH_BAYER_16X16, matrix, 16), 16, true, ctx->prev_masks
+    );
+    return TL_SUCCESS;
+}
+
+tl_result create_dither_ctx(
+    const uint8_t *blue_tile,
+    task_pool     *pool,
+    dither_ctx   **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    *out = calloc(1, sizeof(dither_ctx));
+    CHECK(excv, *out == NULL, TL_ALLOC_FAILURE, return excv);
+    (*out)->blue_tile = blue_tile;
+    (*out)->pool = pool;
+    return excv;
+}
+
+void destroy_dither_ctx(dither_ctx **ctx_ptr) {
+    if (ctx_ptr == NULL || *ctx_ptr == NULL) {
+        return;
+    }
+    free((*ctx_ptr)->err_buf);
+    free(*ctx_ptr);
+    *ctx_ptr = NULL;
+}
+
+/// @brief Adds or removes a dot's share of the energy, a toroidal Gaussian, at every pixel.
+static void spread_energy(
+    double       *energy,
+    const double *kernel,
+    const size_t  pos,
+    const double  sign
+) {
+    const size_t mask = BNOISE_SIDE - 1;
+    const size_t px = pos & mask;
+    const size_t py = pos / BNOISE_SIDE;
+    for (size_t y = 0; y < BNOISE_SIDE; ++y) {
+        const double *k_row = kernel + ((y - py) & mask) * BNOISE_SIDE;
+        double       *e_row = energy + y * BNOISE_SIDE;
+        for (size_t x = 0; x < BNOISE_SIDE; ++x) {
+            e_row[x] += sign * k_row[(x - px) & mask];
+        }
+    }
+}
+
+/// @brief Tightest cluster (most energy among set dots), or largest void (least among unset).
+static size_t find_extreme(
+    const bool   *dots,
+    const double *energy,
+    const bool    cluster
+) {
+    size_t best = 0;
+    double best_energy = cluster ? -DBL_MAX : DBL_MAX;
+    for (size_t i = 0; i < BNOISE_SIDE * BNOISE_SIDE; ++i) {
+        if (dots[i] != cluster) {
+            continue;
+        }
+        if (cluster ? energy[i] > best_energy : energy[i] < best_energy) {
+            best = i;
+            best_energy = energy[i];
+        }
+    }
+    return best;
+}
+
+/// Void-and-cluster. (Ulichney, 1993) A sparse pattern gets its dots moved from the tightest
+/// cluster to the largest void until that settles. Ranks are then given out by taking dots away
+/// from clusters, and by filling voids until the tile is full. Filling voids is the same as
+/// taking away from clusters of unset dots, so one pass covers both halves.
+static tl_result generate_blue_tile(uint8_t *out) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t area = BNOISE_SIDE * BNOISE_SIDE;
+    const size_t initial = area / 10;
+    double      *kernel = malloc(area * sizeof(double));
+    double      *energy = malloc(area * sizeof(double));
+    double      *proto_energy = malloc(area * sizeof(double));
+    bool        *dots = calloc(area, sizeof(bool));
+    bool        *proto = malloc(area * sizeof(bool));
+    size_t      *ranks = malloc(area * sizeof(size_t));
+    CHECK(
+        excv,
+        kernel == NULL || energy == NULL || proto_energy == NULL || dots == NULL ||
+            proto == NULL || ranks == NULL,
+        TL_ALLOC_FAILURE, goto epilogue
+    );
+    for (size_t y = 0; y < BNOISE_SIDE; ++y) {
+        for (size_t x = 0; x < BNOISE_SIDE; ++x) {
+            const double dx = (double)(x < BNOISE_SIDE - x ? x : BNOISE_SIDE - x);
+            const double dy = (double)(y < BNOISE_SIDE - y ? y : BNOISE_SIDE - y);
+            kernel[y * BNOISE_SIDE + x] =
+                exp(-(dx * dx + dy * dy) / (2.0 * BNOISE_SIGMA * BNOISE_SIGMA));
+        }
+    }
+    for (size_t i = 0; i < area; ++i) {
+        energy[i] = 0.0;
+    }
+
+    // Fixed seed, the same tile comes out every time.
+    uint32_t state = 0x9E3779B9u;
+    for (size_t placed = 0; placed < initial;) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const size_t pos = state % area;
+        if (dots[pos]) {
+            continue;
+        }
+        dots[pos] = true;
+        spread_energy(energy, kernel, pos, 1.0);
+        placed++;
+    }
+    for (size_t i = 0; i < area; ++i) {
+        const size_t cluster = find_extreme(dots, energy, true);
+        dots[cluster] = false;
+        spread_energy(energy, kernel, cluster, -1.0);
+        const size_t vd = find_extreme(dots, energy, false);
+        dots[vd] = true;
+        spread_energy(energy, kernel, vd, 1.0);
+        if (vd == cluster) {
+            break;
+        }
+    }
+    memcpy(proto, dots, area * sizeof(bool));
+    memcpy(proto_energy, energy, area * sizeof(double));
+    for (size_t rank = initial; rank-- > 0;) {
+        const size_t cluster = find_extreme(dots, energy, true);
+        dots[cluster] = false;
+        spread_energy(energy, kernel, cluster, -1.0);
+        ranks[cluster] = rank;
+    }
+    memcpy(dots, proto, area * sizeof(bool));
+    memcpy(energy, proto_energy, area * sizeof(double));
+    for (size_t rank = initial; rank < area; ++rank) {
+        const size_t vd = find_extreme(dots, energy, false);
+        dots[vd] = true;
+        spread_energy(energy, kernel, vd, 1.0);
+        ranks[vd] = rank;
+    }
+    for (size_t i = 0; i < area; ++i) {
+        out[i] = (uint8_t)(ranks[i] * (UINT8_MAX + 1) / area);
+    }
+epilogue:
+    free(kernel);
+    free(energy);
+    free(proto_energy);
+    free(dots);
+    free(proto);
+    free(ranks);
+    return excv;
+}
+
+/// @brief Path of the cached tile, next to the executable.
+static tl_result blue_cache_path(
+    WCHAR *dir_out,
+    WCHAR *path_out
+) {
+    static const WCHAR *cache_dir = L"assets";
+    static const WCHAR *cache_file = L"bnoise64.raw";
+    tl_result           excv = TL_SUCCESS;
+    WCHAR               exec_path[MAX_PATH];
+    DWORD               get_exec = GetModuleFileNameW(NULL, exec_path, MAX_PATH);
+    CHECK(excv, get_exec >= MAX_PATH || get_exec == 0, TL_OS_ERR, return excv);
+    HRESULT hr_remove = PathCchRemoveFileSpec(exec_path, MAX_PATH);
+    CHECK(excv, !SUCCEEDED(hr_remove), TL_OS_ERR, return excv);
+    HRESULT hr_dir = PathCchCombine(dir_out, MAX_PATH, exec_path, cache_dir);
+    CHECK(excv, !SUCCEEDED(hr_dir), TL_OS_ERR, return excv);
+    HRESULT hr_file = PathCchCombine(path_out, MAX_PATH, dir_out, cache_file);
+    CHECK(excv, !SUCCEEDED(hr_file), TL_OS_ERR, return excv);
+    return excv;
+}
+
+/// @brief Reads the cached tile. False when there's none, or it isn't exactly one tile.
+static bool read_blue_cache(
+    const WCHAR *path,
+    uint8_t     *out
+) {
+    FILE *data = NULL;
+    if (_wfopen_s(&data, path, L"rb") != 0 || data == NULL) {
+        return false;
+    }
+    const size_t area = BNOISE_SIDE * BNOISE_SIDE;
+    const bool   read = fread(out, sizeof(uint8_t), area, data) == area && fgetc(data) == EOF;
+    fclose(data);
+    return read;
+}
+
+tl_result create_blue_tile(uint8_t **out) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+    const size_t area = BNOISE_SIDE * BNOISE_SIDE;
+    WCHAR        dir[MAX_PATH];
+    WCHAR        path[MAX_PATH];
+    uint8_t     *rows = malloc(area);
+    uint8_t     *tile = malloc(area);
+    CHECK(excv, rows == NULL || tile == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    TRY(excv, blue_cache_path(dir, path), goto epilogue);
+    if (!read_blue_cache(path, rows)) {
+        TRY(excv, generate_blue_tile(rows), goto epilogue);
+
+        // The cache only saves time. Failing to write it leaves the tile to be generated again.
+        FILE *data = NULL;
+        CreateDirectoryW(dir, NULL);
+        if (_wfopen_s(&data, path, L"wb") == 0 && data != NULL) {
+            const bool written = fwrite(rows, sizeof(uint8_t), area, data) == area;
+            if (fclose(data) != 0 || !written) {
+                _wremove(path);
+            }
+        }
+    }
+    tile_pixels(rows, BNOISE_SIDE, BNOISE_SIDE, tile);
+    *out = tile;
+    tile = NULL;
+epilogue:
+    free(rows);
+    free(tile);
+    return excv;
+}
+
+void destroy_blue_tile(uint8_t **tile_ptr) {
+    if (tile_ptr == NULL || *tile_ptr == NULL) {
+        return;
+    }
+    free(*tile_ptr);
+    *tile_ptr = NULL;
+}
+
+tl_result apply_dither(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    raw_frame        *rframe
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, rframe == NULL, TL_NULL_ARG, return excv);
+    const cell_rect all = {
+        .col = 0,
+        .row = 0,
+        .wdth = rframe->fwidth / BRAILLE_CHAR_DOT_WDTH,
+        .ln = rframe->flength / BRAILLE_CHAR_DOT_LN
+    };
+    TRY(excv, dither_rect(ctx, dmode, rframe, &all), return excv);
+    return excv;
+}
+
+tl_result apply_dither_rect(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    raw_frame        *rframe,
+    const cell_rect  *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, ctx == NULL || rframe == NULL || rect == NULL, TL_NULL_ARG, return excv);
+    CHECK(
+        excv, dmode < 0 || dmode >= DTH_MODES || !dither_reusable(dmode, ctx->stable),
+        TL_INVALID_ARG, return excv
+    );
+    CHECK(
+        excv,
+        rect->col + rect->wdth > rframe->fwidth / BRAILLE_CHAR_DOT_WDTH ||
+            rect->row + rect->ln > rframe->flength / BRAILLE_CHAR_DOT_LN,
+        TL_INVALID_ARG, return excv
+    );
+    TRY(excv, dither_rect(ctx, dmode, rframe, rect), return excv);
+    return excv;
+}
+
+static tl_result dither_rect(
+    dither_ctx       *ctx,
+    const dither_mode dmode,
+    raw_frame        *rframe,
+    const cell_rect  *rect
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, dmode < 0 || dmode >= DTH_MODES, TL_INVALID_ARG, return excv);
+    CHECK(excv, rframe == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, ctx == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, !rframe->tiled, TL_INVALID_ARG, return excv);
+
+    // Diffusion ignores `rect`, it only ever gets whole frames. Dot diffusion doesn't, it's local.
+    static tl_result (*const dither_funcs[DTH_MODES])(
+        dither_ctx *ctx, raw_frame *, const cell_rect *
+    ) = {
+        [DTH_THRESHOLDING] = threshold,  [DTH_BAYER_4X4] = bayer_4x4,
+        [DTH_BAYER_8X8] = bayer_8x8,     [DTH_BAYER_16X16] = bayer_16x16,
+        [DTH_BLUE] = blue_dth,           [DTH_HALFTONE] = halftone,
+        [DTH_DOT_DIFFUSION] = dot_dth,   [DTH_BLOCK_DIFFUSION] = block_dth,
+        [DTH_PATTERN] = pattern_dth,
+#define X(dmode, fn, str, div, ...) [dmode] = fn,
+        DIFFUSION_LIST
+#undef X
+    };
+    TRY(excv, dither_funcs[dmode](ctx, rframe, rect), return excv);
+    return excv;
+}
@@ -0,0 +1,135 @@
+#include "tl_errors.h"
+#include "tl_mailbox.h"
+#include "tl_pch.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+tl_result create_frame_mailbox(
+    HANDLE          post_ev,
+    frame_mailbox **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    frame_mailbox *mb = malloc(sizeof(frame_mailbox));
+    CHECK(excv, mb == NULL, TL_ALLOC_FAILURE, return excv);
+    for (size_t i = 0; i < 3; ++i) {
+        out_frame *frame = &mb->frames[i];
+        frame->bytes = NULL;
+        frame->capacity = 0;
+        frame->length = 0;
+        frame->clear = false;
+        frame->serial = 0;
+        frame->posted_at = 0.0;
+    }
+    mb->back = &mb->frames[0];
+    mb->slot = &mb->frames[1];
+    mb->front = &mb->frames[2];
+    mb->fresh = false;
+    mb->status_length = 0;
+    mb->status_fresh = false;
+    InitializeSRWLock(&mb->srw_slot);
+    mb->post_ev = post_ev;
+    *out = mb;
+    return excv;
+}
+
+void destroy_frame_mailbox(frame_mailbox **mb_ptr) {
+    if (mb_ptr == NULL || *mb_ptr == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        free((*mb_ptr)->frames[i].bytes);
+    }
+    free(*mb_ptr);
+    *mb_ptr = NULL;
+}
+
+tl_result mailbox_back(
+    frame_mailbox *mb,
+    const size_t   bsize,
+    out_frame    **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, mb == NULL || out == NULL, TL_NULL_ARG, return excv);
+
+    out_frame *frame = mb->back;
+    if (frame->capacity < bsize) {
+        free(frame->bytes);
+        frame->capacity = 0;
+        frame->bytes = malloc(bsize);
+        CHECK(excv, frame->bytes == NULL, TL_ALLOC_FAILURE, return excv);
+        frame->capacity = bsize;
+    }
+    frame->length = 0;
+    frame->clear = false;
+    *out = frame;
+    return excv;
+}
+
+bool mailbox_post(frame_mailbox *mb) {
+    mb->back->posted_at = mono_time();
+    AcquireSRWLockExclusive(&mb->srw_slot);
+    const bool replaced = mb->fresh;
+    out_frame *posted = mb->back;
+    mb->back = mb->slot;
+    mb->slot = posted;
+    mb->fresh = true;
+
+    // `back` is now the replaced frame, if any.
+    if (replaced && mb->back->clear) {
+        posted->clear = true;
+    }
+    ReleaseSRWLockExclusive(&mb->srw_slot);
+    if (mb->post_ev) {
+        SetEvent(mb->post_ev);
+    }
+    return replaced;
+}
+
+out_frame *mailbox_take(frame_mailbox *mb) {
+    AcquireSRWLockExclusive(&mb->srw_slot);
+    if (!mb->fresh) {
+        ReleaseSRWLockExclusive(&mb->srw_slot);
+        return NULL;
+    }
+    out_frame *taken = mb->slot;
+    mb->slot = mb->front;
+    mb->front = taken;
+    mb->fresh = false;
+    ReleaseSRWLockExclusive(&mb->srw_slot);
+    return taken;
+}
+
+void mailbox_post_status(
+    frame_mailbox *mb,
+    const char    *line,
+    const size_t   length
+) {
+    const size_t bsize = length < GBUFFER_BSIZE ? length : GBUFFER_BSIZE;
+    AcquireSRWLockExclusive(&mb->srw_slot);
+    memcpy(mb->status, line, bsize);
+    mb->status_length = bsize;
+    mb->status_fresh = true;
+    ReleaseSRWLockExclusive(&mb->srw_slot);
+    if (mb->post_ev) {
+        SetEvent(mb->post_ev);
+    }
+}
+
+bool mailbox_take_status(
+    frame_mailbox *mb,
+    char          *out,
+    size_t        *length_out
+) {
+    AcquireSRWLockExclusive(&mb->srw_slot);
+    const bool fresh = mb->status_fresh;
+    if (fresh) {
+        memcpy(out, mb->status, mb->status_length);
+        *length_out = mb->status_length;
+        mb->status_fresh = false;
+    }
+    ReleaseSRWLockExclusive(&mb->srw_slot);
+    return fresh;
+}
@@ -24,21 +24,30 @@ int main() {
 
     HANDLE stdinh = GetStdHandle(STD_INPUT_HANDLE);
     CHECK(excv, stdinh == INVALID_HANDLE_VALUE || stdinh == NULL, TL_OS_ERR, return excv);
+    HANDLE stdouth = GetStdHandle(STD_OUTPUT_HANDLE);
+    CHECK(excv, stdouth == INVALID_HANDLE_VALUE || stdouth == NULL, TL_OS_ERR, return excv);
     
     DWORD stdin_defm = 0;
+    DWORD stdout_defm = 0;
     uint8_t get_ret = 0;
     get_ret |= GetConsoleMode(stdinh, &stdin_defm) ? 0 : 0x10;
+    get_ret |= GetConsoleMode(stdouth, &stdout_defm) ? 0 : 0x01;
     CHECK(excv, get_ret != 0, TL_CONSOLE_ERR, return excv);
 
     DWORD stdin_newm =
         stdin_defm & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT | ENABLE_PROCESSED_INPUT);
 
+    // Frames go out as VT sequences.
+    DWORD stdout_newm = stdout_defm | ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+
     set_ret = 0;
     set_ret |= SetConsoleMode(stdinh, stdin_newm) ? 0 : 0x01;
+    set_ret |= SetConsoleMode(stdouth, stdout_newm) ? 0 : 0x10;
     CHECK(excv, set_ret != 0, TL_CONSOLE_ERR, return excv);
 
     TRY(excv, player_exec(argc, wargv), break);
 
     SetConsoleMode(stdinh, stdin_defm);
+    SetConsoleMode(stdouth, stdout_defm);
     return excv;
 }
\ No newline at end of file
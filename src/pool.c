@@ -0,0 +1,347 @@
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_pool.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+#define DEQUE_MASK (POOL_DEQUE_CAPACITY - 1)
+
+// Worker the calling thread runs as, if any. Decides where submissions go.
+static _Thread_local pool_worker *tls_worker = NULL;
+
+/// @brief One `pool_parallel_for()` call. Lives on the caller's stack.
+typedef struct pool_for {
+    pool_task     helpers[POOL_FOR_HELPERS];
+    atomic_size_t next;    // Next item to claim.
+    atomic_size_t running; // Helpers submitted and not finished.
+    size_t        count;
+    pool_for_fn   fn;
+    void         *arg;
+    HANDLE        done; // Caller's `for_done`.
+} pool_for;
+
+/// @brief Owner only. Returns false when full.
+static bool deque_push(
+    task_deque *dq,
+    pool_task  *task
+) {
+    const size_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    const size_t t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    if (b - t > DEQUE_MASK) {
+        return false;
+    }
+    atomic_store_explicit(&dq->slots[b & DEQUE_MASK], task, memory_order_relaxed);
+
+    // Publishes the slot before the new bottom.
+    atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+/// @brief Owner only. Takes the newest task.
+static pool_task *deque_pop(task_deque *dq) {
+    const size_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+
+    // The bottom store has to be visible before top is read, or a thief and the owner can both
+    // take the last task.
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+    if ((ptrdiff_t)(b - t) < 0) {
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    pool_task *task = atomic_load_explicit(&dq->slots[b & DEQUE_MASK], memory_order_relaxed);
+    if (b != t) {
+        return task;
+    }
+
+    // Last task. Whoever moves top first gets it.
+    const bool won = atomic_compare_exchange_strong_explicit(
+        &dq->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed
+    );
+    atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+    return won ? task : NULL;
+}
+
+/// @brief Any thread. Takes the oldest task. Can fail spuriously when racing other threads.
+static pool_task *deque_steal(task_deque *dq) {
+    size_t t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const size_t b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+    if ((ptrdiff_t)(b - t) <= 0) {
+        return NULL;
+    }
+    pool_task *task = atomic_load_explicit(&dq->slots[t & DEQUE_MASK], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(
+            &dq->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed
+        )) {
+        return NULL;
+    }
+    return task;
+}
+
+static void inject(
+    task_pool *pool,
+    pool_task *task
+) {
+    task->next = NULL;
+    AcquireSRWLockExclusive(&pool->srw_inject);
+    if (pool->inject_tail == NULL) {
+        pool->inject_head = task;
+    } else {
+        pool->inject_tail->next = task;
+    }
+    pool->inject_tail = task;
+    ReleaseSRWLockExclusive(&pool->srw_inject);
+}
+
+static pool_task *take_injected(task_pool *pool) {
+    AcquireSRWLockExclusive(&pool->srw_inject);
+    pool_task *task = pool->inject_head;
+    if (task != NULL) {
+        pool->inject_head = task->next;
+        if (pool->inject_head == NULL) {
+            pool->inject_tail = NULL;
+        }
+    }
+    ReleaseSRWLockExclusive(&pool->srw_inject);
+    return task;
+}
+
+/// @brief Own deque first, then the injection queue, then everyone else's deque.
+static pool_task *find_task(pool_worker *wk) {
+    task_pool *pool = wk->pool;
+    pool_task *task = deque_pop(&wk->deque);
+    if (task != NULL) {
+        return task;
+    }
+    task = take_injected(pool);
+    if (task != NULL) {
+        return task;
+    }
+    for (size_t i = 0; i < pool->worker_count; ++i) {
+        const size_t victim = (wk->victim + i) % pool->worker_count;
+        if (victim == wk->idx) {
+            continue;
+        }
+        task = deque_steal(&pool->workers[victim].deque);
+        if (task != NULL) {
+            // Keep going back to a victim that had work.
+            wk->victim = victim;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static unsigned int _stdcall pool_worker_main(void *data) {
+    pool_worker *wk = (pool_worker *)data;
+    task_pool   *pool = wk->pool;
+    tls_worker = wk;
+    while (true) {
+        pool_task *task = find_task(wk);
+        if (task != NULL) {
+            task->fn(task, wk->idx);
+            continue;
+        }
+        if (get_atomic_bool(&pool->stop)) {
+            break;
+        }
+        WaitForSingleObject(pool->work_sem, INFINITE);
+    }
+    tls_worker = NULL;
+    return TL_SUCCESS;
+}
+
+tl_result create_task_pool(
+    const size_t worker_count,
+    const bool   pin_threads,
+    task_pool  **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    size_t count = worker_count;
+    if (count == 0) {
+        SYSTEM_INFO sys_info;
+        GetSystemInfo(&sys_info);
+        count = sys_info.dwNumberOfProcessors > 0 ? sys_info.dwNumberOfProcessors : 1;
+    }
+    task_pool *pool = malloc(sizeof(task_pool));
+    CHECK(excv, pool == NULL, TL_ALLOC_FAILURE, return excv);
+    set_atomic_bool(&pool->stop, false);
+    InitializeSRWLock(&pool->srw_inject);
+    pool->inject_head = NULL;
+    pool->inject_tail = NULL;
+    pool->worker_count = 0;
+    pool->work_sem = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+    pool->workers = _aligned_malloc(count * sizeof(pool_worker), CACHE_LINE_BSIZE);
+    CHECK(excv, pool->work_sem == NULL, TL_OS_ERR, goto epilogue);
+    CHECK(excv, pool->workers == NULL, TL_ALLOC_FAILURE, goto epilogue);
+
+    // Deques are all set up before any worker can try stealing from them.
+    for (size_t i = 0; i < count; ++i) {
+        pool_worker *wk = &pool->workers[i];
+        atomic_init(&wk->deque.bottom, 0);
+        atomic_init(&wk->deque.top, 0);
+        wk->pool = pool;
+        wk->idx = i;
+        wk->victim = (i + 1) % count;
+        wk->thread = 0;
+        wk->for_done = NULL;
+    }
+    pool->worker_count = count;
+    for (size_t i = 0; i < count; ++i) {
+        pool_worker *wk = &pool->workers[i];
+        wk->for_done = CreateEventW(NULL, false, false, NULL);
+        CHECK(excv, wk->for_done == NULL, TL_OS_ERR, goto epilogue);
+        wk->thread = (HANDLE)_beginthreadex(NULL, 0, pool_worker_main, (void *)wk, 0, NULL);
+        CHECK(excv, wk->thread == 0, TL_OS_ERR, goto epilogue);
+        if (pin_threads) {
+            const size_t mask_bits = sizeof(DWORD_PTR) * 8;
+            SetThreadAffinityMask(wk->thread, (DWORD_PTR)1 << (i % mask_bits));
+        }
+    }
+    *out = pool;
+epilogue:
+    if (excv != TL_SUCCESS) {
+        destroy_task_pool(&pool);
+    }
+    return excv;
+}
+
+void destroy_task_pool(task_pool **pool_ptr) {
+    if (pool_ptr == NULL || *pool_ptr == NULL) {
+        return;
+    }
+    task_pool *pool = *pool_ptr;
+    set_atomic_bool(&pool->stop, true);
+    if (pool->workers != NULL) {
+        ReleaseSemaphore(pool->work_sem, (LONG)pool->worker_count, NULL);
+        for (size_t i = 0; i < pool->worker_count; ++i) {
+            if (pool->workers[i].thread != 0) {
+                WaitForSingleObject(pool->workers[i].thread, INFINITE);
+                CloseHandle(pool->workers[i].thread);
+            }
+            if (pool->workers[i].for_done != NULL) {
+                CloseHandle(pool->workers[i].for_done);
+            }
+        }
+    }
+    if (pool->work_sem) {
+        CloseHandle(pool->work_sem);
+    }
+    _aligned_free(pool->workers);
+    free(pool);
+    *pool_ptr = NULL;
+}
+
+void pool_submit(
+    task_pool *pool,
+    pool_task *task
+) {
+    pool_worker *wk = tls_worker;
+    if (wk == NULL || wk->pool != pool || !deque_push(&wk->deque, task)) {
+        inject(pool, task);
+    }
+    ReleaseSemaphore(pool->work_sem, 1, NULL);
+}
+
+size_t pool_worker_count(const task_pool *pool) { return pool->worker_count; }
+
+static void claim_items(pool_for *pf) {
+    size_t item;
+    while ((item = atomic_fetch_add_explicit(&pf->next, 1, memory_order_relaxed)) < pf->count) {
+        pf->fn(pf->arg, item);
+    }
+}
+
+static void pool_for_main(
+    pool_task   *task,
+    const size_t worker
+) {
+    (void)worker;
+    pool_for    *pf = (pool_for *)task->arg;
+    const HANDLE done = pf->done;
+    claim_items(pf);
+
+    // Publishes the items' results to the caller. The caller can return as soon as this hits 0,
+    // taking `pf` with it, hence `done` being read beforehand.
+    if (atomic_fetch_sub_explicit(&pf->running, 1, memory_order_acq_rel) == 1) {
+        SetEvent(done);
+    }
+}
+
+void pool_parallel_for(
+    task_pool        *pool,
+    const size_t      count,
+    const pool_for_fn fn,
+    void             *arg
+) {
+    pool_worker *wk = tls_worker;
+    pool_for     pf;
+    atomic_init(&pf.next, 0);
+    atomic_init(&pf.running, 0);
+    pf.count = count;
+    pf.fn = fn;
+    pf.arg = arg;
+    pf.done = wk != NULL ? wk->for_done : NULL;
+
+    // Helpers only go on the caller's own deque, so the ones nobody takes can be taken back.
+    size_t helpers = 0;
+    if (wk != NULL && wk->pool == pool && count > 1) {
+        const size_t idle = pool->worker_count - 1;
+        helpers = count - 1 < idle ? count - 1 : idle;
+        helpers = helpers < POOL_FOR_HELPERS ? helpers : POOL_FOR_HELPERS;
+    }
+    size_t pushed = 0;
+    for (; pushed < helpers; ++pushed) {
+        pf.helpers[pushed].fn = pool_for_main;
+        pf.helpers[pushed].arg = &pf;
+        atomic_fetch_add_explicit(&pf.running, 1, memory_order_relaxed);
+        if (!deque_push(&wk->deque, &pf.helpers[pushed])) {
+            atomic_fetch_sub_explicit(&pf.running, 1, memory_order_relaxed);
+            break;
+        }
+    }
+    if (pushed > 0) {
+        ReleaseSemaphore(pool->work_sem, (LONG)pushed, NULL);
+    }
+    claim_items(&pf);
+
+    // Helpers were pushed last, so any still queued are the newest tasks on the deque. They have
+    // nothing left to claim, so taking them back only means dropping them and the wakeups posted
+    // for them. Some of those may have been consumed already, in which case there's less to take.
+    size_t reclaimed = 0;
+    while (reclaimed < pushed) {
+        pool_task *task = deque_pop(&wk->deque);
+        if (task == NULL) {
+            break;
+        }
+        if (task->arg != &pf) {
+            deque_push(&wk->deque, task);
+            break;
+        }
+        ++reclaimed;
+    }
+    if (reclaimed > 0) {
+        atomic_fetch_sub_explicit(&pf.running, reclaimed, memory_order_relaxed);
+    }
+    for (size_t i = 0; i < reclaimed; ++i) {
+        if (WaitForSingleObject(pool->work_sem, 0) != WAIT_OBJECT_0) {
+            break;
+        }
+    }
+
+    // The rest were stolen and are running. Short ones are polled out, then the caller sleeps
+    // until the last one sets `for_done`. One set after an earlier call came out of its poll
+    // can still be pending, hence the loop.
+    for (size_t spin = 0; atomic_load_explicit(&pf.running, memory_order_acquire) > 0; ++spin) {
+        if (spin < POOL_FOR_SPINS) {
+            YieldProcessor();
+        } else {
+            WaitForSingleObject(pf.done, INFINITE);
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include "lz4.h"
+#include "tl_dither.h"
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_pool.h"
+#include "tl_render.h"
+#include "tl_scale.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+/// @brief Whether any cell of a block differs from the reference by more than `CHG_CELL_SAD`.
+static bool block_changed(
+    const uint8_t   *cur,
+    const uint8_t   *ref,
+    const size_t     cell_wdth,
+    const cell_rect *block
+) {
+    const size_t bsize = block->wdth * BRAILLE_DOTS_PER_CHAR;
+    for (size_t cy = block->row; cy < block->row + block->ln; ++cy) {
+        const size_t   offset = (cy * cell_wdth + block->col) * BRAILLE_DOTS_PER_CHAR;
+        const uint8_t *a = cur + offset;
+        const uint8_t *b = ref + offset;
+        size_t         i = 0;
+
+        // Two cells per load. `_mm_sad_epu8()` sums each half on its own, one cell each.
+        for (; i + 2 * BRAILLE_DOTS_PER_CHAR <= bsize; i += 2 * BRAILLE_DOTS_PER_CHAR) {
+            const __m128i sad = _mm_sad_epu8(
+                _mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i))
+            );
+            if (_mm_cvtsi128_si32(sad) > CHG_CELL_SAD || _mm_extract_epi16(sad, 4) > CHG_CELL_SAD) {
+                return true;
+            }
+        }
+        if (i < bsize) {
+            const __m128i sad = _mm_sad_epu8(
+                _mm_loadl_epi64((const __m128i *)(a + i)), _mm_loadl_epi64((const __m128i *)(b + i))
+            );
+            if (_mm_cvtsi128_si32(sad) > CHG_CELL_SAD) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// @brief Copies a block of cells, `cell_bsize` bytes each, between frames of the same bounds.
+static void copy_block(
+    uint8_t         *dst,
+    const uint8_t   *src,
+    const size_t     cell_wdth,
+    const cell_rect *block,
+    const size_t     cell_bsize
+) {
+    for (size_t cy = block->row; cy < block->row + block->ln; ++cy) {
+        const size_t offset = (cy * cell_wdth + block->col) * cell_bsize;
+        memcpy(dst + offset, src + offset, block->wdth * cell_bsize);
+    }
+}
+
+/// @brief Dithers and packs a run of changed blocks, then empties it.
+static tl_result flush_run(
+    render_ctx *ctx,
+    render_job *job,
+    cell_rect  *run
+) {
+    tl_result excv = TL_SUCCESS;
+    if (run->wdth == 0) {
+        return excv;
+    }
+    TRY(excv, apply_dither_rect(ctx->dctx, job->dmode, ctx->scaled, run), return excv);
+    pack_braille_rect(ctx->scaled, run, job->masks);
+    run->wdth = 0;
+    return excv;
+}
+
+/// @brief Renders the blocks that changed since the reference, copies the others from it.
+static tl_result render_changed(
+    render_ctx *ctx,
+    render_job *job
+) {
+    tl_result         excv = TL_SUCCESS;
+    const con_bounds *bounds = &job->bounds;
+    const render_job *ref = job->ref;
+    const uint8_t    *cur = ctx->scaled->data;
+    cell_rect         block = {.col = 0, .row = 0, .wdth = 0, .ln = 0};
+    for (block.row = 0; block.row < bounds->cell_ln; block.row += CHG_BLOCK_CELL_LN) {
+        const size_t rows_left = bounds->cell_ln - block.row;
+        block.ln = rows_left < CHG_BLOCK_CELL_LN ? rows_left : CHG_BLOCK_CELL_LN;
+
+        // Neighboring changed blocks get dithered in one go.
+        cell_rect run = {.col = 0, .row = block.row, .wdth = 0, .ln = block.ln};
+        for (block.col = 0; block.col < bounds->cell_wdth; block.col += CHG_BLOCK_CELL_WDTH) {
+            const size_t cols_left = bounds->cell_wdth - block.col;
+            block.wdth = cols_left < CHG_BLOCK_CELL_WDTH ? cols_left : CHG_BLOCK_CELL_WDTH;
+            if (block_changed(cur, ref->luma, bounds->cell_wdth, &block)) {
+                copy_block(job->luma, cur, bounds->cell_wdth, &block, BRAILLE_DOTS_PER_CHAR);
+                run.col = run.wdth == 0 ? block.col : run.col;
+                run.wdth += block.wdth;
+                continue;
+            }
+            TRY(excv, flush_run(ctx, job, &run), return excv);
+
+            // Keeps the luminance the copied cells came from, so that slow changes still add up
+            // to a change eventually.
+            copy_block(job->luma, ref->luma, bounds->cell_wdth, &block, BRAILLE_DOTS_PER_CHAR);
+            copy_block(job->masks, ref->masks, bounds->cell_wdth, &block, 1);
+            job->reused_cells += block.wdth * block.ln;
+        }
+        TRY(excv, flush_run(ctx, job, &run), return excv);
+    }
+    return excv;
+}
+
+static tl_result render_frame(
+    render_ctx *ctx,
+    render_job *job
+) {
+    tl_result         excv = TL_SUCCESS;
+    const con_bounds *bounds = &job->bounds;
+    const raw_frame  *raw = &job->dframe->frame;
+    job->supported = bounds->cell_ln != 0 && bounds->cell_wdth != 0 &&
+                     bounds->log_ln * bounds->log_wdth <= MAXIMUM_BUFFER_SIZE &&
+                     bounds->abs_conln * bounds->abs_conwdth <= MAXIMUM_BUFFER_SIZE &&
+                     LZ4_compressBound((int)(bounds->cell_ln * bounds->cell_wdth)) <=
+                         MAXIMUM_BUFFER_SIZE;
+    if (!job->supported) {
+        return excv;
+    }
+    area_scaler *sc = ctx->scaler;
+    if (sc == NULL || sc->src_wdth != raw->fwidth || sc->src_ln != raw->flength ||
+        sc->dst_wdth != bounds->log_wdth || sc->dst_ln != bounds->log_ln) {
+        destroy_area_scaler(&ctx->scaler);
+        TRY(excv,
+            create_area_scaler(
+                raw->fwidth, raw->flength, bounds->log_wdth, bounds->log_ln, &ctx->scaler
+            ),
+            return excv);
+    }
+    TRY(excv, area_scale(ctx->scaler, raw, ctx->scaled), return excv);
+    const render_job *ref = job->ref;
+    const bool        reusable = dither_reusable(job->dmode, job->stable);
+    const bool        matches = reusable && ref != NULL && ref->dmode == job->dmode &&
+                         ref->bounds.cell_ln == bounds->cell_ln &&
+                         ref->bounds.cell_wdth == bounds->cell_wdth;
+    job->reused_cells = 0;
+    ctx->dctx->pts = job->pts;
+    ctx->dctx->stable = job->stable;
+
+    // The reference is the newest frame there is, so it's what dots are held against.
+    ctx->dctx->prev_masks = job->stable && matches ? ref->masks : NULL;
+    if (matches) {
+        TRY(excv, render_changed(ctx, job), return excv);
+    } else {
+        if (reusable) {
+            memcpy(
+                job->luma, ctx->scaled->data,
+                bounds->cell_ln * bounds->cell_wdth * BRAILLE_DOTS_PER_CHAR
+            );
+        }
+        TRY(excv, apply_dither(ctx->dctx, job->dmode, ctx->scaled), return excv);
+        pack_braille(ctx->scaled, job->masks);
+    }
+    job->hash = hash_cells(job->masks, bounds->cell_ln * bounds->cell_wdth);
+    return excv;
+}
+
+/// @brief Pool task rendering one job. (`pool_task_fn`)
+static void render_task(
+    pool_task   *task,
+    const size_t worker
+) {
+    render_job *job = (render_job *)task->arg;
+    renderer   *rd = job->rd;
+
+    // Errors travel back with the job, the dispatcher decides what to do with them.
+    const double start = mono_time();
+    job->excv = render_frame(&rd->ctxs[worker], job);
+    job->cost_s = mono_time() - start;
+    set_atomic_bool(&job->done, true);
+    SetEvent(rd->done_ev);
+}
+
+tl_result create_renderer(
+    task_pool     *pool,
+    const uint8_t *blue_tile,
+    HANDLE         done_ev,
+    renderer     **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, pool == NULL || out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    renderer *rd = malloc(sizeof(renderer));
+    CHECK(excv, rd == NULL, TL_ALLOC_FAILURE, return excv);
+    rd->pool = pool;
+    rd->done_ev = done_ev;
+    rd->ctx_count = 0;
+    rd->ctxs = calloc(pool_worker_count(pool), sizeof(render_ctx));
+    CHECK(excv, rd->ctxs == NULL, TL_ALLOC_FAILURE, goto epilogue);
+
+    rd->ctx_count = pool_worker_count(pool);
+    for (size_t i = 0; i < rd->ctx_count; ++i) {
+        render_ctx *ctx = &rd->ctxs[i];
+        TRY(excv, create_dither_ctx(blue_tile, pool, &ctx->dctx), goto epilogue);
+        ctx->scaled = malloc(sizeof(raw_frame));
+        CHECK(excv, ctx->scaled == NULL, TL_ALLOC_FAILURE, goto epilogue);
+        ctx->scaled->data = malloc(MAXIMUM_BUFFER_SIZE);
+        ctx->scaled->flength = 0;
+        ctx->scaled->fwidth = 0;
+        ctx->scaled->tiled = true;
+        CHECK(excv, ctx->scaled->data == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    }
+    *out = rd;
+epilogue:
+    if (excv != TL_SUCCESS) {
+        destroy_renderer(&rd);
+    }
+    return excv;
+}
+
+void destroy_renderer(renderer **rd_ptr) {
+    if (rd_ptr == NULL || *rd_ptr == NULL) {
+        return;
+    }
+    renderer *rd = *rd_ptr;
+    if (rd->ctxs != NULL) {
+        for (size_t i = 0; i < rd->ctx_count; ++i) {
+            render_ctx *ctx = &rd->ctxs[i];
+            destroy_dither_ctx(&ctx->dctx);
+            destroy_area_scaler(&ctx->scaler);
+            destroy_rawframe(&ctx->scaled);
+        }
+    }
+    free(rd->ctxs);
+    free(rd);
+    *rd_ptr = NULL;
+}
+
+void render_submit(
+    renderer   *rd,
+    render_job *job
+) {
+    job->rd = rd;
+    job->task.fn = render_task;
+    job->task.arg = job;
+    set_atomic_bool(&job->done, false);
+    pool_submit(rd->pool, &job->task);
+}
@@ -0,0 +1,271 @@
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_ring.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+/// @brief Copies `count` elements starting at index `idx` out of the ring, wrapping if needed.
+static void copy_from_slots(
+    const spsc_ring *ring,
+    const size_t     idx,
+    void            *dst,
+    const size_t     count
+) {
+    const size_t slot = idx % ring->capacity;
+    const size_t first = count < ring->capacity - slot ? count : ring->capacity - slot;
+    memcpy(dst, ring->slots + slot * ring->elem_bsize, first * ring->elem_bsize);
+    memcpy(
+        (uint8_t *)dst + first * ring->elem_bsize, ring->slots,
+        (count - first) * ring->elem_bsize
+    );
+}
+
+/// @brief Copies `count` elements into the ring starting at index `idx`, wrapping if needed.
+static void copy_to_slots(
+    spsc_ring   *ring,
+    const size_t idx,
+    const void  *src,
+    const size_t count
+) {
+    const size_t slot = idx % ring->capacity;
+    const size_t first = count < ring->capacity - slot ? count : ring->capacity - slot;
+    memcpy(ring->slots + slot * ring->elem_bsize, src, first * ring->elem_bsize);
+    memcpy(
+        ring->slots, (const uint8_t *)src + first * ring->elem_bsize,
+        (count - first) * ring->elem_bsize
+    );
+}
+
+/// @brief Destroys elements `[from, to)` through `drop`.
+static void drop_range(
+    spsc_ring   *ring,
+    const size_t from,
+    const size_t to
+) {
+    if (ring->drop == NULL) {
+        return;
+    }
+    for (size_t i = from; i != to; ++i) {
+        ring->drop(ring->slots + (i % ring->capacity) * ring->elem_bsize);
+    }
+}
+
+tl_result create_spsc_ring(
+    const size_t capacity,
+    const size_t elem_bsize,
+    void (*drop)(void *elem),
+    HANDLE      space_ev,
+    HANDLE      data_ev,
+    spsc_ring **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, capacity == 0, TL_INVALID_ARG, return excv);
+    CHECK(excv, elem_bsize == 0, TL_INVALID_ARG, return excv);
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    spsc_ring *ring = _aligned_malloc(sizeof(spsc_ring), CACHE_LINE_BSIZE);
+    CHECK(excv, ring == NULL, TL_ALLOC_FAILURE, return excv);
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->mark_idx, 0);
+    atomic_init(&ring->mark_serial, 0);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+    ring->synced_serial = 0;
+    ring->capacity = capacity;
+    ring->elem_bsize = elem_bsize;
+    ring->drop = drop;
+    ring->space_ev = space_ev;
+    ring->data_ev = data_ev;
+    ring->slots = calloc(capacity, elem_bsize);
+    CHECK(excv, ring->slots == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    *out = ring;
+epilogue:
+    if (excv != TL_SUCCESS) {
+        destroy_spsc_ring(&ring);
+    }
+    return excv;
+}
+
+void destroy_spsc_ring(spsc_ring **ring_ptr) {
+    if (ring_ptr == NULL || *ring_ptr == NULL) {
+        return;
+    }
+    spsc_ring *ring = *ring_ptr;
+    if (ring->slots != NULL) {
+        drop_range(
+            ring, get_atomic_size_t_relaxed(&ring->head), get_atomic_size_t_relaxed(&ring->tail)
+        );
+    }
+    free(ring->slots);
+    _aligned_free(ring);
+    *ring_ptr = NULL;
+}
+
+size_t spsc_push(
+    spsc_ring   *ring,
+    const void  *src,
+    const size_t count
+) {
+    const size_t tail = get_atomic_size_t_relaxed(&ring->tail);
+    size_t       free_slots = ring->capacity - (tail - ring->cached_head);
+    if (free_slots < count) {
+        // Only touch the consumer's line when the cached head says we're out of room.
+        ring->cached_head = get_atomic_size_t(&ring->head);
+        free_slots = ring->capacity - (tail - ring->cached_head);
+    }
+    const size_t n = count < free_slots ? count : free_slots;
+    if (n == 0) {
+        return 0;
+    }
+    copy_to_slots(ring, tail, src, n);
+    set_atomic_size_t(&ring->tail, tail + n);
+    if (ring->data_ev != NULL) {
+        SetEvent(ring->data_ev);
+    }
+    return n;
+}
+
+bool spsc_push_wait(
+    spsc_ring     *ring,
+    const void    *src,
+    const size_t   count,
+    spsc_cancel_fn cancel,
+    void          *ctx
+) {
+    size_t pushed = 0;
+    while (true) {
+        pushed += spsc_push(ring, (const uint8_t *)src + pushed * ring->elem_bsize, count - pushed);
+        if (pushed == count) {
+            return true;
+        }
+        if (cancel != NULL && cancel(ctx)) {
+            return false;
+        }
+        if (ring->space_ev == NULL) {
+            Sleep(POLLING_RATE_MS);
+            continue;
+        }
+        WaitForSingleObject(ring->space_ev, INFINITE);
+    }
+}
+
+size_t spsc_pop(
+    spsc_ring   *ring,
+    void        *dst,
+    const size_t count
+) {
+    const size_t head = get_atomic_size_t_relaxed(&ring->head);
+    size_t       used_slots = ring->cached_tail - head;
+    if (used_slots < count) {
+        ring->cached_tail = get_atomic_size_t(&ring->tail);
+        used_slots = ring->cached_tail - head;
+    }
+    const size_t n = count < used_slots ? count : used_slots;
+    if (n == 0) {
+        return 0;
+    }
+    copy_from_slots(ring, head, dst, n);
+    set_atomic_size_t(&ring->head, head + n);
+    if (ring->space_ev != NULL) {
+        SetEvent(ring->space_ev);
+    }
+    return n;
+}
+
+size_t spsc_peek(
+    spsc_ring   *ring,
+    void        *dst,
+    const size_t count
+) {
+    const size_t head = get_atomic_size_t_relaxed(&ring->head);
+    size_t       used_slots = ring->cached_tail - head;
+    if (used_slots < count) {
+        ring->cached_tail = get_atomic_size_t(&ring->tail);
+        used_slots = ring->cached_tail - head;
+    }
+    const size_t n = count < used_slots ? count : used_slots;
+    if (n != 0) {
+        copy_from_slots(ring, head, dst, n);
+    }
+    return n;
+}
+
+bool spsc_pop_wait(
+    spsc_ring     *ring,
+    void          *dst,
+    const size_t   count,
+    spsc_cancel_fn cancel,
+    void          *ctx
+) {
+    size_t popped = 0;
+    while (true) {
+        popped += spsc_pop(ring, (uint8_t *)dst + popped * ring->elem_bsize, count - popped);
+        if (popped == count) {
+            return true;
+        }
+        if (cancel != NULL && cancel(ctx)) {
+            return false;
+        }
+        if (ring->data_ev == NULL) {
+            Sleep(POLLING_RATE_MS);
+            continue;
+        }
+        WaitForSingleObject(ring->data_ev, INFINITE);
+    }
+}
+
+size_t spsc_size(spsc_ring *ring) {
+    ring->cached_tail = get_atomic_size_t(&ring->tail);
+    return ring->cached_tail - get_atomic_size_t_relaxed(&ring->head);
+}
+
+void spsc_mark(
+    spsc_ring   *ring,
+    const size_t serial
+) {
+    atomic_store_explicit(
+        &ring->mark_idx, get_atomic_size_t_relaxed(&ring->tail), memory_order_relaxed
+    );
+
+    // Publishes `mark_idx` along with the serial.
+    set_atomic_size_t(&ring->mark_serial, serial);
+}
+
+bool spsc_flush(
+    spsc_ring   *ring,
+    const size_t serial
+) {
+    if (ring->synced_serial == serial) {
+        return true;
+    }
+    // Without a matching mark, everything up to a tail read before the mark check is stale.
+    // With one, the tail is read again afterwards so that it can't be behind the mark.
+    const size_t head = get_atomic_size_t_relaxed(&ring->head);
+    size_t       tail = get_atomic_size_t(&ring->tail);
+    const bool   synced = get_atomic_size_t(&ring->mark_serial) == serial;
+    size_t       end = tail;
+    if (synced) {
+        end = get_atomic_size_t_relaxed(&ring->mark_idx);
+        tail = get_atomic_size_t(&ring->tail);
+    }
+
+    // The consumer may have already popped past the mark before it saw the new serial.
+    if (end - head > tail - head) {
+        end = head;
+    }
+    if (end != head) {
+        drop_range(ring, head, end);
+        set_atomic_size_t(&ring->head, end);
+        if (ring->space_ev != NULL) {
+            SetEvent(ring->space_ev);
+        }
+    }
+    ring->cached_tail = tail;
+    if (synced) {
+        ring->synced_serial = serial;
+    }
+    return synced;
+}
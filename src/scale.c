@@ -0,0 +1,165 @@
+#include "tl_dither.h"
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_scale.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+/// @brief Fills in the weights mapping `src_n` pixels to `dst_n` along one axis.
+static tl_result build_axis(
+    const size_t src_n,
+    const size_t dst_n,
+    scale_axis  *axis
+) {
+    tl_result    excv = TL_SUCCESS;
+    const double ratio = (double)src_n / (double)dst_n;
+
+    // A destination pixel straddles at most ceil(ratio) + 1 source pixels.
+    size_t taps = (size_t)ceil(ratio) + 1;
+    axis->taps = taps < src_n ? taps : src_n;
+    axis->start = malloc(dst_n * sizeof(size_t));
+    axis->weights = calloc(dst_n * axis->taps, sizeof(uint16_t));
+    CHECK(excv, axis->start == NULL, TL_ALLOC_FAILURE, return excv);
+    CHECK(excv, axis->weights == NULL, TL_ALLOC_FAILURE, return excv);
+
+    const uint16_t one = 1 << SCALE_WEIGHT_BITS;
+    for (size_t i = 0; i < dst_n; ++i) {
+        const double lo = (double)i * ratio;
+        const double hi = (double)(i + 1) * ratio;
+        size_t       start = (size_t)lo;
+        if (start + axis->taps > src_n) {
+            start = src_n - axis->taps;
+        }
+        axis->start[i] = start;
+
+        uint16_t *w = axis->weights + i * axis->taps;
+        uint32_t  sum = 0;
+        size_t    heaviest = 0;
+        for (size_t k = 0; k < axis->taps; ++k) {
+            const double px_lo = (double)(start + k);
+            const double covered = fmin(hi, px_lo + 1.0) - fmax(lo, px_lo);
+            if (covered <= 0.0) {
+                continue;
+            }
+            w[k] = (uint16_t)(covered / ratio * (double)one + 0.5);
+            sum += w[k];
+            heaviest = w[k] > w[heaviest] ? k : heaviest;
+        }
+        // Rounding leftovers go to the heaviest tap so that flat areas stay exactly flat.
+        w[heaviest] = (uint16_t)((int32_t)w[heaviest] + ((int32_t)one - (int32_t)sum));
+    }
+    return excv;
+}
+
+static void destroy_axis(scale_axis *axis) {
+    free(axis->start);
+    free(axis->weights);
+    axis->start = NULL;
+    axis->weights = NULL;
+}
+
+tl_result create_area_scaler(
+    const size_t  src_wdth,
+    const size_t  src_ln,
+    const size_t  dst_wdth,
+    const size_t  dst_ln,
+    area_scaler **out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, src_wdth == 0 || src_ln == 0, TL_INVALID_ARG, return excv);
+    CHECK(excv, dst_wdth == 0 || dst_ln == 0, TL_INVALID_ARG, return excv);
+    CHECK(
+        excv, dst_wdth % BRAILLE_CHAR_DOT_WDTH != 0 || dst_ln % BRAILLE_CHAR_DOT_LN != 0,
+        TL_INVALID_ARG, return excv
+    );
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    area_scaler *scaler = calloc(1, sizeof(area_scaler));
+    CHECK(excv, scaler == NULL, TL_ALLOC_FAILURE, return excv);
+    scaler->src_wdth = src_wdth;
+    scaler->src_ln = src_ln;
+    scaler->dst_wdth = dst_wdth;
+    scaler->dst_ln = dst_ln;
+    TRY(excv, build_axis(src_wdth, dst_wdth, &scaler->x), goto epilogue);
+    TRY(excv, build_axis(src_ln, dst_ln, &scaler->y), goto epilogue);
+    scaler->row = malloc(src_wdth * sizeof(uint32_t));
+    CHECK(excv, scaler->row == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    *out = scaler;
+epilogue:
+    if (excv != TL_SUCCESS) {
+        destroy_area_scaler(&scaler);
+    }
+    return excv;
+}
+
+void destroy_area_scaler(area_scaler **scaler_ptr) {
+    if (scaler_ptr == NULL || *scaler_ptr == NULL) {
+        return;
+    }
+    destroy_axis(&(*scaler_ptr)->x);
+    destroy_axis(&(*scaler_ptr)->y);
+    free((*scaler_ptr)->row);
+    free(*scaler_ptr);
+    *scaler_ptr = NULL;
+}
+
+tl_result area_scale(
+    const area_scaler *scaler,
+    const raw_frame   *src,
+    raw_frame         *dst
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, scaler == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, src == NULL || dst == NULL, TL_NULL_ARG, return excv);
+    CHECK(
+        excv, src->fwidth != scaler->src_wdth || src->flength != scaler->src_ln, TL_INVALID_ARG,
+        return excv
+    );
+    static const uint32_t row_round = 1 << (SCALE_WEIGHT_BITS - SCALE_ROW_BITS - 1);
+    static const uint32_t px_round = 1 << (SCALE_WEIGHT_BITS + SCALE_ROW_BITS - 1);
+
+    const size_t sw = scaler->src_wdth;
+    const size_t cell_wdth = scaler->dst_wdth / BRAILLE_CHAR_DOT_WDTH;
+    uint32_t    *row = scaler->row;
+    for (size_t y = 0; y < scaler->dst_ln; ++y) {
+        const uint8_t  *src_rows = src->data + scaler->y.start[y] * sw;
+        const uint16_t *wy = scaler->y.weights + y * scaler->y.taps;
+
+        // Vertical. Weighted sum of whole rows, one source row at a time.
+        memset(row, 0, sw * sizeof(uint32_t));
+        for (size_t k = 0; k < scaler->y.taps; ++k) {
+            const uint32_t w = wy[k];
+            const uint8_t *src_row = src_rows + k * sw;
+            if (w == 0) {
+                continue;
+            }
+            for (size_t x = 0; x < sw; ++x) {
+                row[x] += w * src_row[x];
+            }
+        }
+
+        // Keeps SCALE_ROW_BITS of the fraction for the second pass. Max 255 << 8.
+        for (size_t x = 0; x < sw; ++x) {
+            row[x] = (row[x] + row_round) >> (SCALE_WEIGHT_BITS - SCALE_ROW_BITS);
+        }
+
+        // Horizontal, written out tiled. A row of pixels is one dot row of a row of cells.
+        uint8_t     *out = dst->data + tiled_px_idx(cell_wdth, 0, y - y % BRAILLE_CHAR_DOT_LN);
+        const size_t dot_row = y % BRAILLE_CHAR_DOT_LN;
+        for (size_t x = 0; x < scaler->dst_wdth; ++x) {
+            const uint32_t *px = row + scaler->x.start[x];
+            const uint16_t *wx = scaler->x.weights + x * scaler->x.taps;
+            uint32_t        acc = 0;
+            for (size_t k = 0; k < scaler->x.taps; ++k) {
+                acc += wx[k] * px[k];
+            }
+            out[tiled_px_idx(cell_wdth, x, dot_row)] =
+                (uint8_t)((acc + px_round) >> (SCALE_WEIGHT_BITS + SCALE_ROW_BITS));
+        }
+    }
+    dst->fwidth = scaler->dst_wdth;
+    dst->flength = scaler->dst_ln;
+    dst->tiled = true;
+    return excv;
+}
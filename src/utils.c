@@ -1,108 +1,162 @@
+#include "tl_dither.h"
 #include "tl_errors.h"
+#include "tl_mailbox.h"
 #include "tl_pch.h"
+#include "tl_pool.h"
+#include "tl_ring.h"
 #include "tl_types.h"
 #include "tl_utils.h"
 
-void set_atomic_bool(
-    atomic_bool_t *b,
-    bool           value
-) {
-    if (b == NULL) {
-        return;
-    }
-    _InterlockedExchange((volatile LONG *)b, value);
+void begin_ctrl_write(player *pl) {
+    const size_t seq = atomic_load_explicit(&pl->ctrl.seq, memory_order_relaxed);
+    atomic_store_explicit(&pl->ctrl.seq, seq + 1, memory_order_relaxed);
+
+    // Keeps the field stores below from being reordered before the odd sequence.
+    atomic_thread_fence(memory_order_release);
 }
 
-bool get_atomic_bool(atomic_bool_t *b) {
-    if (b == NULL) {
-        return false;
-    }
-    return (bool)_InterlockedOr((volatile LONG *)b, 0);
+void end_ctrl_write(player *pl) {
+    const size_t seq = atomic_load_explicit(&pl->ctrl.seq, memory_order_relaxed);
+    atomic_store_explicit(&pl->ctrl.seq, seq + 1, memory_order_release);
+    wake_threads(pl);
 }
 
-void flip_atomic_bool(atomic_bool_t *b) {
-    if (b == NULL) {
-        return;
-    }
-    _InterlockedXor((volatile LONG *)b, 1);
+void get_ctrl_snapshot(
+    player        *pl,
+    ctrl_snapshot *out
+) {
+    player_ctrl *ctrl = &pl->ctrl;
+    size_t       seq_start = 0;
+    size_t       seq_end = 0;
+    do {
+        seq_start = atomic_load_explicit(&ctrl->seq, memory_order_acquire);
+        if (seq_start & 1) {
+            YieldProcessor();
+            continue;
+        }
+        union double_u64 du64;
+        out->shutdown = atomic_load_explicit(&ctrl->shutdown, memory_order_relaxed) != 0;
+        out->playing = atomic_load_explicit(&ctrl->playing, memory_order_relaxed) != 0;
+        out->looping = atomic_load_explicit(&ctrl->looping, memory_order_relaxed) != 0;
+        out->invalidated = atomic_load_explicit(&ctrl->invalidated, memory_order_relaxed) != 0;
+        out->muted = atomic_load_explicit(&ctrl->muted, memory_order_relaxed) != 0;
+        out->debug_print = atomic_load_explicit(&ctrl->debug_print, memory_order_relaxed) != 0;
+        out->stable_dots = atomic_load_explicit(&ctrl->stable_dots, memory_order_relaxed) != 0;
+        du64.u64 = atomic_load_explicit(&ctrl->volume, memory_order_relaxed);
+        out->volume = du64.d;
+        du64.u64 = atomic_load_explicit(&ctrl->seek_speed, memory_order_relaxed);
+        out->seek_speed = du64.d;
+        out->dither_mode =
+            (dither_mode)atomic_load_explicit(&ctrl->dither_mode, memory_order_relaxed);
+        out->color_mode = (color_mode)atomic_load_explicit(&ctrl->color_mode, memory_order_relaxed);
+        out->serial = atomic_load_explicit(&ctrl->serial, memory_order_relaxed);
+        out->layout = atomic_load_explicit(&ctrl->layout, memory_order_relaxed);
+
+        // Keeps the field loads above from being reordered after the closing sequence load.
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&ctrl->seq, memory_order_relaxed);
+    } while ((seq_start & 1) || seq_start != seq_end);
 }
 
-void set_atomic_double(
-    atomic_double_t *dbl,
-    double           value
+void signal_wake(
+    player          *pl,
+    const ev_handles ev
 ) {
-    if (dbl == NULL) {
+    if (pl->ev_hndles == NULL || pl->ev_hndles[ev] == NULL) {
         return;
     }
-    union double_l64 dl64;
-    dl64.d = value;
-    _InterlockedExchange64(dbl, dl64.l64);
+    SetEvent(pl->ev_hndles[ev]);
 }
 
-double get_atomic_double(atomic_double_t *dbl) {
-    if (dbl == NULL) {
-        return 0.0;
+void wake_threads(player *pl) {
+    for (size_t i = 0; i < MAX_EVENTS; ++i) {
+        signal_wake(pl, (ev_handles)i);
     }
-    union double_l64 dl64;
-    dl64.l64 = _InterlockedOr64(dbl, 0);
-    return dl64.d;
 }
 
-void add_atomic_double(
-    atomic_double_t *dbl,
-    double           addend
+void wait_for_wake(
+    player          *pl,
+    const ev_handles ev,
+    const DWORD      timeout_ms
 ) {
-    if (dbl == NULL) {
+    if (pl->ev_hndles == NULL || pl->ev_hndles[ev] == NULL) {
+        Sleep(timeout_ms == INFINITE ? POLLING_RATE_MS : timeout_ms);
         return;
     }
-    union double_l64 dl64;
-    union double_l64 dl64_r;
-    dl64.l64 = _InterlockedOr64(dbl, 0);
-    while (true) {
-        LONG64 cmp = dl64.l64;
-        dl64_r.d = dl64.d + addend;
-        LONG64 v = _InterlockedCompareExchange64(dbl, dl64_r.l64, cmp);
-        if (v != cmp) {
-            dl64.l64 = v;
-            continue;
-        }
-        break;
-    }
+    WaitForSingleObject(pl->ev_hndles[ev], timeout_ms);
 }
 
-void set_atomic_size_t(
-    atomic_size_t *st,
-    size_t         value
+void wait_for_deadline(
+    player          *pl,
+    const ev_handles ev,
+    HANDLE           timer,
+    const double     delay_s
 ) {
-    if (st == NULL) {
+    // Relative due times are negative, in 100ns units.
+    const LARGE_INTEGER due = {.QuadPart = -(LONGLONG)(delay_s * 1e7)};
+    if (pl->ev_hndles == NULL || pl->ev_hndles[ev] == NULL || timer == NULL ||
+        !SetWaitableTimer(timer, &due, 0, NULL, NULL, false)) {
+        wait_for_wake(pl, ev, (DWORD)(delay_s * 1000.0));
         return;
     }
-    _InterlockedExchange64(st, value);
+    const HANDLE hndles[2] = {pl->ev_hndles[ev], timer};
+    WaitForMultipleObjects(2, hndles, false, INFINITE);
 }
 
-size_t get_atomic_size_t(atomic_size_t *st) {
-    if (st == NULL) {
-        return 0;
+HANDLE create_deadline_timer(void) {
+    HANDLE timer =
+        CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (timer == NULL) {
+        // High resolution timers need Windows 10 1803 or later.
+        timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
     }
-    return (size_t)_InterlockedOr64(st, 0);
+    return timer;
 }
 
-void add_atomic_size_t(
-    atomic_size_t *st,
-    size_t         addend
-) {
-    if (st == NULL) {
-        return;
+double mono_time(void) {
+    static LARGE_INTEGER freq = {.QuadPart = 0};
+    LARGE_INTEGER        now;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
     }
-    while (true) {
-        LONG64 cmp = _InterlockedOr64(st, 0);
-        LONG64 r = cmp + (LONG64)addend;
-        if (cmp == _InterlockedCompareExchange64(st, r, cmp)) {
-            break;
-        }
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+}
+
+double get_main_clock(player *pl) {
+    AcquireSRWLockShared(&pl->srw_mclock);
+    const double main_clock = get_atomic_double(&pl->main_clock);
+    ReleaseSRWLockShared(&pl->srw_mclock);
+    return main_clock;
+}
+
+double get_present_clock(
+    player              *pl,
+    const ctrl_snapshot *snap
+) {
+    // The audio callback moves the clock in steps. In between, it keeps on moving in real time,
+    // but never past where the next step will put it.
+    AcquireSRWLockShared(&pl->srw_mclock);
+    const double main_clock = get_atomic_double(&pl->main_clock);
+    const double step = get_atomic_double(&pl->clock_step);
+    const double stamp = get_atomic_double(&pl->clock_stamp);
+    ReleaseSRWLockShared(&pl->srw_mclock);
+    const double since = mono_time() - stamp;
+    if (!snap->playing || snap->invalidated || since < 0.0) {
+        return main_clock;
     }
+    return main_clock + (since < step ? since : step);
+}
+
+bool serial_changed(void *watch) {
+    serial_watch *w = (serial_watch *)watch;
+    return get_atomic_bool(&w->pl->ctrl.shutdown) ||
+           get_atomic_size_t(&w->pl->ctrl.serial) != w->serial;
 }
 
+/// @brief `spsc_ring` drop callback for rings of `con_frame*`s.
+static void drop_conframe(void *slot) { destroy_conframe((con_frame **)slot); }
+
 tl_result create_media_mtdta(
     const WCHAR        *media_path,
     const media_mtdta **out
@@ -120,6 +174,9 @@ tl_result create_media_mtdta(
     mtdta->duration = 0.0;
     mtdta->height = 0;
     mtdta->width = 0;
+    mtdta->fps_num = V_FPS;
+    mtdta->fps_den = 1;
+    mtdta->fps = V_FPS;
     mtdta->video_present = false;
     mtdta->audio_present = false;
 
@@ -134,8 +191,8 @@ tl_result create_media_mtdta(
 
     const WCHAR *const cmds_tmpl[3] = {
         L"ffprobe -v quiet -show_entries format=duration -of csv=p=0:nk=1 \"%ls\"",
-        L"ffprobe -v quiet -select_streams v:0 -show_entries stream=width,height -of "
-        L"csv=p=0:nk=1 \"%ls\"",
+        L"ffprobe -v quiet -select_streams v:0 -show_entries stream=width,height,r_frame_rate,"
+        L"avg_frame_rate -of csv=p=0:nk=1 \"%ls\"",
         L"ffprobe -v quiet -select_streams a:0 -show_entries stream=index -of csv=p=0:nk=1 "
         L"\"%ls\""
     };
@@ -153,10 +210,27 @@ tl_result create_media_mtdta(
         case 0:
             ret = swscanf_s(proc_res, L"%lf", &mtdta->duration);
             break;
-        case 1:
-            ret = swscanf_s(proc_res, L"%zu,%zu", &mtdta->width, &mtdta->height);
-            mtdta->video_present = ret == 2;
+        case 1: {
+            UINT num[2] = {0};
+            UINT den[2] = {0};
+            ret = swscanf_s(
+                proc_res, L"%zu,%zu,%u/%u,%u/%u", &mtdta->width, &mtdta->height, &num[0], &den[0],
+                &num[1], &den[1]
+            );
+            mtdta->video_present = ret >= 2;
+
+            // Unknown rates come out as 0/0. Variable rate sources tend to report the timebase as
+            // `r_frame_rate`, in which case the average is the closer guess.
+            for (size_t i = 0; i < 2 && ret >= 4 + 2 * (int)i; ++i) {
+                if (num[i] != 0 && den[i] != 0 && (double)num[i] / (double)den[i] <= V_MAX_FPS) {
+                    mtdta->fps_num = num[i];
+                    mtdta->fps_den = den[i];
+                    mtdta->fps = (double)num[i] / (double)den[i];
+                    break;
+                }
+            }
             break;
+        }
         case 2:
             mtdta->audio_present = wcslen(proc_res) > 0;
             break;
@@ -184,7 +258,7 @@ tl_result create_thread_data(
 ) {
     tl_result excv = TL_SUCCESS;
     CHECK(excv, pl == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, id < 0 || id > 3, TL_INVALID_ARG, return excv);
+    CHECK(excv, id < 0 || id > VIDEO_WRITE_THREAD_ID, TL_INVALID_ARG, return excv);
     CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
 
@@ -212,6 +286,12 @@ unsigned int _stdcall thread_dispatcher(void *data) {
     case VIDEO_PROD_THREAD_ID:
         TRY(excv, vpthread_exec(thdata), return excv);
         break;
+    case VIDEO_READ_THREAD_ID:
+        TRY(excv, vrthread_exec(thdata), return excv);
+        break;
+    case VIDEO_WRITE_THREAD_ID:
+        TRY(excv, vwthread_exec(thdata), return excv);
+        break;
     }
     return excv;
 }
@@ -224,79 +304,144 @@ tl_result create_player(
     CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
 
-    player *pl = malloc(sizeof(player));
+    player *pl = _aligned_malloc(sizeof(player), CACHE_LINE_BSIZE);
     CHECK(excv, pl == NULL, TL_ALLOC_FAILURE, return excv);
 
-    pl->video_rbuffer = NULL;
-    pl->audio_rbuffer = NULL;
+    pl->video_ring = NULL;
+    pl->audio_ring = NULL;
+    pl->raw_ring = NULL;
+    pl->raw_free = NULL;
+    pl->raw_pool = NULL;
+    pl->pool = NULL;
+    pl->mailbox = NULL;
+    pl->blue_tile = NULL;
     pl->gwpvbuffer = NULL;
     pl->gwcvbuffer = NULL;
     pl->th_hndles = NULL;
     pl->ev_hndles = NULL;
     pl->th_data = NULL;
     pl->media_mtdta = NULL;
-    set_atomic_bool(&pl->shutdown, false);
-    set_atomic_bool(&pl->playing, false);
-    set_atomic_bool(&pl->looping, false);
-    set_atomic_bool(&pl->invalidated, false);
-    set_atomic_bool(&pl->muted, false);
-    set_atomic_bool(&pl->debug_print, false);
+    set_atomic_size_t(&pl->ctrl.seq, 0);
+    set_atomic_bool(&pl->ctrl.shutdown, false);
+    set_atomic_bool(&pl->ctrl.playing, false);
+    set_atomic_bool(&pl->ctrl.looping, false);
+    set_atomic_bool(&pl->ctrl.invalidated, false);
+    set_atomic_bool(&pl->ctrl.muted, false);
+    set_atomic_bool(&pl->ctrl.debug_print, false);
+    set_atomic_bool(&pl->ctrl.stable_dots, false);
     set_atomic_double(&pl->main_clock, 0.0);
-    set_atomic_double(&pl->volume, 0.0);
-    set_atomic_double(&pl->seek_speed, 0.0);
-    set_atomic_size_t(&pl->serial, 0);
-    set_atomic_size_t(&pl->aread_idx, 0);
-    set_atomic_size_t(&pl->awrite_idx, 0);
-    set_atomic_size_t(&pl->vwrite_idx, 0);
-    set_atomic_size_t(&pl->vread_idx, 0);
-    set_atomic_size_t(&pl->dither_mode, DTH_BAYER_16X16);
-    set_atomic_size_t(&pl->color_mode, CLM_WHITE);
-    set_atomic_size_t(&pl->ext_assets_ptr, 0);
+    set_atomic_double(&pl->clock_stamp, 0.0);
+    set_atomic_double(&pl->clock_step, 0.0);
+    set_atomic_double(&pl->ctrl.volume, 0.0);
+    set_atomic_double(&pl->ctrl.seek_speed, 0.0);
+    set_atomic_size_t(&pl->ctrl.serial, 0);
+    set_atomic_size_t(&pl->ctrl.layout, 0);
+    set_atomic_size_t(&pl->ctrl.output_target, 0);
+    set_atomic_size_t(&pl->ctrl.dither_mode, DTH_BAYER_16X16);
+    set_atomic_size_t(&pl->ctrl.color_mode, CLM_WHITE);
+    set_atomic_size_t(&pl->last_fhash, 0);
+    set_atomic_size_t(&pl->skipped_frames, 0);
+    set_atomic_size_t(&pl->replaced_frames, 0);
+    set_atomic_size_t(&pl->still_frames, 0);
+    set_atomic_size_t(&pl->output_level, OUT_FULL);
+    set_atomic_double(&pl->output_bps, 0.0);
+    set_atomic_double(&pl->write_s, 0.0);
+    set_atomic_double(&pl->write_latency, 0.0);
+    set_atomic_size_t(&pl->culled_frames, 0);
+    set_atomic_size_t(&pl->quality_level, QLT_FULL);
+    set_atomic_double(&pl->render_load, 0.0);
+    set_atomic_double(&pl->render_reuse, 0.0);
+    set_atomic_double(&pl->changed_cells, 0.0);
     InitializeSRWLock(&pl->srw_mclock);
     pl->active_threads = 0;
 
     TRY(excv, create_media_mtdta(media_path, &pl->media_mtdta), goto epilogue);
 
+    static const ev_handles event_handles[MAX_EVENTS] = {
+        AUDIO_EVENT_WAKE_HNDLE, AUDIO_PROD_EVENT_WAKE_HNDLE, VIDEO_EVENT_WAKE_HNDLE,
+        VIDEO_PROD_EVENT_WAKE_HNDLE, VIDEO_READ_EVENT_WAKE_HNDLE, VIDEO_WRITE_EVENT_WAKE_HNDLE
+    };
+    static const th_handles thread_handles[MAX_THREADS] = {
+        AUDIO_THREAD_HNDLE, AUDIO_PROD_THREAD_HNDLE, VIDEO_THREAD_HNDLE, VIDEO_PROD_THREAD_HNDLE,
+        VIDEO_READ_THREAD_HNDLE, VIDEO_WRITE_THREAD_HNDLE
+    };
+    static const thread_id thread_ids[MAX_THREADS] = {
+        AUDIO_THREAD_ID, AUDIO_PROD_THREAD_ID, VIDEO_THREAD_ID, VIDEO_PROD_THREAD_ID,
+        VIDEO_READ_THREAD_ID, VIDEO_WRITE_THREAD_ID
+    };
+    pl->ev_hndles = calloc(MAX_EVENTS, sizeof(HANDLE));
+    CHECK(excv, pl->ev_hndles == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    for (size_t i = 0; i < (pl->media_mtdta->video_present ? MAX_EVENTS : AUDIO_THREADS); ++i) {
+        pl->ev_hndles[event_handles[i]] = CreateEventW(NULL, false, false, NULL);
+        CHECK(excv, pl->ev_hndles[event_handles[i]] == NULL, TL_OS_ERR, goto epilogue);
+    }
+
     // Audio present regardless of presence in media file due to clock/time-keeping.
-    int16_t *audio_rbuffer = calloc(ABUFFER_BSIZE / sizeof(int16_t), sizeof(int16_t));
-    CHECK(excv, audio_rbuffer == NULL, TL_ALLOC_FAILURE, goto epilogue);
-    pl->audio_rbuffer = audio_rbuffer;
+    // The callback never blocks on the ring, so there is no consumer event to signal.
+    TRY(excv,
+        create_spsc_ring(
+            ABUFFER_BSIZE / sizeof(s16_le), sizeof(s16_le), NULL,
+            pl->ev_hndles[AUDIO_PROD_EVENT_WAKE_HNDLE], NULL, &pl->audio_ring
+        ),
+        goto epilogue);
 
     if (pl->media_mtdta->video_present) {
-        con_frame **video_rbuffer =
-            calloc(VBUFFER_BSIZE / sizeof(con_frame *), sizeof(con_frame *));
+        TRY(excv,
+            create_spsc_ring(
+                VBUFFER_FRAMES, sizeof(con_frame *), drop_conframe,
+                pl->ev_hndles[VIDEO_PROD_EVENT_WAKE_HNDLE], pl->ev_hndles[VIDEO_EVENT_WAKE_HNDLE],
+                &pl->video_ring
+            ),
+            goto epilogue);
+
+        // Every pooled frame starts out free. Neither ring can fill up since together they never
+        // hold more than the pool, so only their consumers get an event.
+        TRY(excv,
+            create_spsc_ring(
+                VRAW_FRAMES, sizeof(dec_frame *), NULL, NULL,
+                pl->ev_hndles[VIDEO_PROD_EVENT_WAKE_HNDLE], &pl->raw_ring
+            ),
+            goto epilogue);
+        TRY(excv,
+            create_spsc_ring(
+                VRAW_FRAMES, sizeof(dec_frame *), NULL, NULL,
+                pl->ev_hndles[VIDEO_READ_EVENT_WAKE_HNDLE], &pl->raw_free
+            ),
+            goto epilogue);
+        pl->raw_pool = calloc(VRAW_FRAMES, sizeof(dec_frame));
+        CHECK(excv, pl->raw_pool == NULL, TL_ALLOC_FAILURE, goto epilogue);
+        for (size_t i = 0; i < VRAW_FRAMES; ++i) {
+            dec_frame *dframe = &pl->raw_pool[i];
+            dframe->frame.data = malloc(MAXIMUM_BUFFER_SIZE);
+            CHECK(excv, dframe->frame.data == NULL, TL_ALLOC_FAILURE, goto epilogue);
+            spsc_push(pl->raw_free, &dframe, 1);
+        }
+
+        TRY(excv,
+            create_frame_mailbox(pl->ev_hndles[VIDEO_WRITE_EVENT_WAKE_HNDLE], &pl->mailbox),
+            goto epilogue);
+
+        // Loaded ahead of playback, switching to blue noise or resizing never waits on it.
+        TRY(excv, create_blue_tile(&pl->blue_tile), goto epilogue);
+
+        // One worker per logical processor. Left unpinned, the player's own threads share the
+        // same cores.
+        TRY(excv, create_task_pool(0, false, &pl->pool), goto epilogue);
+
         char *gwpvbuffer = malloc(GWVBUFFER_BSIZE);
         char *gwcvbuffer = malloc(GWVBUFFER_BSIZE);
-        CHECK(excv, video_rbuffer == NULL, TL_ALLOC_FAILURE, goto epilogue);
         CHECK(excv, gwpvbuffer == NULL, TL_ALLOC_FAILURE, goto epilogue);
         CHECK(excv, gwcvbuffer == NULL, TL_ALLOC_FAILURE, goto epilogue);
 
-        pl->video_rbuffer = video_rbuffer;
         pl->gwpvbuffer = gwpvbuffer;
         pl->gwcvbuffer = gwcvbuffer;
     }
 
-    static const ev_handles event_handles[MAX_EVENTS] = {
-        AUDIO_PROD_EVENT_WAKE_HNDLE, VIDEO_PROD_EVENT_WAKE_HNDLE
-    };
-    static const th_handles thread_handles[MAX_THREADS] = {
-        AUDIO_THREAD_HNDLE, AUDIO_PROD_THREAD_HNDLE, VIDEO_THREAD_HNDLE, VIDEO_PROD_THREAD_HNDLE
-    };
-    static const thread_id thread_ids[MAX_THREADS] = {
-        AUDIO_THREAD_ID, AUDIO_PROD_THREAD_ID, VIDEO_THREAD_ID, VIDEO_PROD_THREAD_ID
-    };
-    pl->ev_hndles = calloc(MAX_EVENTS, sizeof(HANDLE));
-    CHECK(excv, pl->ev_hndles == NULL, TL_ALLOC_FAILURE, goto epilogue);
-    for (size_t i = 0; i < (pl->media_mtdta->video_present ? MAX_EVENTS : MAX_EVENTS / 2); ++i) {
-        pl->ev_hndles[i] = CreateEventW(NULL, false, false, NULL);
-        CHECK(excv, pl->ev_hndles[i] == INVALID_HANDLE_VALUE, TL_OS_ERR, goto epilogue);
-    }
-
     pl->th_data = calloc(MAX_THREADS, sizeof(thread_data *));
     CHECK(excv, pl->th_data == NULL, TL_ALLOC_FAILURE, goto epilogue);
     pl->th_hndles = calloc(MAX_THREADS, sizeof(HANDLE));
     CHECK(excv, pl->th_hndles == NULL, TL_ALLOC_FAILURE, goto epilogue);
-    for (size_t i = 0; i < (pl->media_mtdta->video_present ? MAX_THREADS : MAX_THREADS / 2); ++i) {
+    for (size_t i = 0; i < (pl->media_mtdta->video_present ? MAX_THREADS : AUDIO_THREADS); ++i) {
         TRY(excv, create_thread_data(pl, thread_ids[i], &pl->th_data[i]), goto epilogue);
         pl->th_hndles[thread_handles[i]] =
             (HANDLE)_beginthreadex(NULL, 0, thread_dispatcher, (void *)pl->th_data[i], 0, NULL);
@@ -311,6 +456,27 @@ epilogue:
     return excv;
 }
 
+tl_result create_frame_codec(frame_codec **out) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, *out != NULL, TL_ALREADY_INITIALIZED, return excv);
+
+    frame_codec *codec = malloc(sizeof(frame_codec));
+    CHECK(excv, codec == NULL, TL_ALLOC_FAILURE, return excv);
+    codec->ref_cells = 0;
+    codec->since_key = 0;
+    codec->cur = malloc(MAXIMUM_BUFFER_SIZE);
+    codec->ref = malloc(MAXIMUM_BUFFER_SIZE);
+    CHECK(excv, codec->cur == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    CHECK(excv, codec->ref == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    *out = codec;
+epilogue:
+    if (excv != TL_SUCCESS) {
+        destroy_frame_codec(&codec);
+    }
+    return excv;
+}
+
 tl_result copy_rawframe(
     raw_frame  *src,
     raw_frame **dst_out
@@ -328,6 +494,7 @@ tl_result copy_rawframe(
     memcpy((*dst_out)->data, src->data, sizeof(uint8_t) * src->flength * src->fwidth);
     (*dst_out)->flength = src->flength;
     (*dst_out)->fwidth = src->fwidth;
+    (*dst_out)->tiled = src->tiled;
     return excv;
 }
 
@@ -353,11 +520,9 @@ void destroy_player(player **pl_ptr) {
         return;
     }
     if ((*pl_ptr)->th_hndles) {
-        set_atomic_bool(&(*pl_ptr)->shutdown, true);
-        SetEvent((*pl_ptr)->ev_hndles[AUDIO_PROD_EVENT_WAKE_HNDLE]);
-        if ((*pl_ptr)->media_mtdta->video_present) {
-            SetEvent((*pl_ptr)->ev_hndles[VIDEO_PROD_EVENT_WAKE_HNDLE]);
-        }
+        begin_ctrl_write(*pl_ptr);
+        set_atomic_bool(&(*pl_ptr)->ctrl.shutdown, true);
+        end_ctrl_write(*pl_ptr);
         WaitForMultipleObjects((*pl_ptr)->active_threads, (*pl_ptr)->th_hndles, true, INFINITE);
         for (size_t i = 0; i < (*pl_ptr)->active_threads; ++i) {
             if ((*pl_ptr)->th_hndles == NULL) {
@@ -373,9 +538,25 @@ void destroy_player(player **pl_ptr) {
         }
         free((*pl_ptr)->th_data);
     }
+    // Tasks signal player events, the pool goes before them.
+    destroy_task_pool(&(*pl_ptr)->pool);
+
+    // Rings and the mailbox go before the events they signal.
+    destroy_spsc_ring(&(*pl_ptr)->video_ring);
+    destroy_spsc_ring(&(*pl_ptr)->audio_ring);
+    destroy_spsc_ring(&(*pl_ptr)->raw_ring);
+    destroy_spsc_ring(&(*pl_ptr)->raw_free);
+    destroy_frame_mailbox(&(*pl_ptr)->mailbox);
+    destroy_blue_tile(&(*pl_ptr)->blue_tile);
+    if ((*pl_ptr)->raw_pool) {
+        for (size_t i = 0; i < VRAW_FRAMES; ++i) {
+            free((*pl_ptr)->raw_pool[i].frame.data);
+        }
+        free((*pl_ptr)->raw_pool);
+    }
     if ((*pl_ptr)->ev_hndles) {
         for (size_t i = 0; i < MAX_EVENTS; ++i) {
-            if ((*pl_ptr)->ev_hndles == NULL) {
+            if ((*pl_ptr)->ev_hndles[i] == NULL) {
                 continue;
             }
             CloseHandle((*pl_ptr)->ev_hndles[i]);
@@ -384,18 +565,8 @@ void destroy_player(player **pl_ptr) {
     }
     free((*pl_ptr)->gwcvbuffer);
     free((*pl_ptr)->gwpvbuffer);
-    if ((*pl_ptr)->video_rbuffer != NULL) {
-        for (size_t i = 0; i < VBUFFER_BSIZE / sizeof(con_frame *); ++i) {
-            destroy_conframe(&(*pl_ptr)->video_rbuffer[i]);
-        }
-    }
-    void *extasst =
-        _InterlockedExchangePointer((volatile PVOID *)&((*pl_ptr)->ext_assets_ptr), NULL);
-    free(extasst);
-    free((*pl_ptr)->video_rbuffer);
-    free((*pl_ptr)->audio_rbuffer);
     destroy_media_mtdta(&(*pl_ptr)->media_mtdta);
-    free(*pl_ptr);
+    _aligned_free(*pl_ptr);
     *pl_ptr = NULL;
 }
 
@@ -417,34 +588,61 @@ void destroy_rawframe(raw_frame **frame_ptr) {
     *frame_ptr = NULL;
 }
 
+void destroy_frame_codec(frame_codec **codec_ptr) {
+    if (codec_ptr == NULL || *codec_ptr == NULL) {
+        return;
+    }
+    free((*codec_ptr)->cur);
+    free((*codec_ptr)->ref);
+    free(*codec_ptr);
+    *codec_ptr = NULL;
+}
+
 void playback_stats(player *pl) {
+    static const char *const qlt_reprs[QLT_LEVELS] = {
+#define X(lvl, str, ordered, scale, cost) str,
+        QUALITY_LIST
+#undef X
+    };
+    static const char *const out_reprs[OUT_LEVELS] = {
+#define X(lvl, str, rate_div, scale) str,
+        OUTPUT_LIST
+#undef X
+    };
     static char       *dthrepr = "";
     static char       *clmrepr = "";
     static dither_mode stored_dth = DTH_MODES;
     static color_mode  stored_clm = CLM_COUNT;
-    AcquireSRWLockShared(&pl->srw_mclock);
-    const double main_clock = get_atomic_double(&pl->main_clock);
-    ReleaseSRWLockShared(&pl->srw_mclock);
-    COORD c = {.X = 0, .Y = 0};
-    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), c);
+    ctrl_snapshot      snap;
+    get_ctrl_snapshot(pl, &snap);
+    const double main_clock = get_main_clock(pl);
 
-    if (pl->dither_mode != stored_dth) {
-        switch ((dither_mode)get_atomic_size_t(&pl->dither_mode)) {
+    if (snap.dither_mode != stored_dth) {
+        switch (snap.dither_mode) {
         case DTH_BAYER_4X4:
             dthrepr = "BAYER 4x4";
             break;
         case DTH_BLUE:
             dthrepr = "BLUE";
             break;
-        case DTH_FLOYD_STEINBERG:
-            dthrepr = "FLOYD-STEINBERG";
-            break;
         case DTH_HALFTONE:
             dthrepr = "HALFTONE";
             break;
-        case DTH_SIERRA_LITE:
-            dthrepr = "SIERRA-LITE";
+        case DTH_DOT_DIFFUSION:
+            dthrepr = "DOT DIFFUSION";
+            break;
+        case DTH_BLOCK_DIFFUSION:
+            dthrepr = "BLOCK DIFFUSION";
             break;
+        case DTH_PATTERN:
+            dthrepr = "PATTERN MATCH";
+            break;
+#define X(dmode, fn, str, div, ...)                                                                \
+    case dmode:                                                                                    \
+        dthrepr = str;                                                                             \
+        break;
+            DIFFUSION_LIST
+#undef X
         case DTH_THRESHOLDING:
             dthrepr = "DISABLED";
             break;
@@ -458,10 +656,10 @@ void playback_stats(player *pl) {
             dthrepr = "UNHANDLED DITHER MODE";
             break;
         }
-        stored_dth = (dither_mode)pl->dither_mode;
+        stored_dth = snap.dither_mode;
     }
-    if (pl->color_mode != stored_clm) {
-        switch ((color_mode)get_atomic_size_t(&pl->color_mode)) {
+    if (snap.color_mode != stored_clm) {
+        switch (snap.color_mode) {
         case CLM_DARK_BLUE:
             clmrepr = "DARK BLUE  ";
             break;
@@ -511,28 +709,60 @@ void playback_stats(player *pl) {
             clmrepr = "UNKNOWN CLM ";
             break;
         }
-        stored_clm = (color_mode)get_atomic_size_t(&pl->color_mode);
+        stored_clm = snap.color_mode;
     }
 
-    fprintf(
-        stdout,
+    char      line[GBUFFER_BSIZE];
+    const int length = snprintf(
+        line, sizeof(line),
         "PLAYING: %s | "
         "LOOPING: %s | "
         "MUTED: %s | "
         "TIMESTAMP: %.2lf | "
         "VOLUME: %u | "
-        "DITHERING: %s | "
-        "COLOR: %s                     \n",
-        get_atomic_bool(&pl->playing) ? "Y" : "N", get_atomic_bool(&pl->looping) ? "Y" : "N",
-        get_atomic_bool(&pl->muted) ? "Y" : "N", main_clock,
-        (uint8_t)(get_atomic_double(&pl->volume) * 100.0), dthrepr, clmrepr
+        "DITHERING: %s%s (%.0lf CELLS/FRAME) | "
+        "COLOR: %s | "
+        "QUALITY: %s (LOAD %.2lf) | "
+        "OUTPUT: %s (%.0lf KB/s, WRITE %.1lf ms, LATENCY %.1lf ms)",
+        snap.playing ? "Y" : "N", snap.looping ? "Y" : "N", snap.muted ? "Y" : "N", main_clock,
+        (uint8_t)(snap.volume * 100.0), dthrepr, snap.stable_dots ? " STABLE" : "",
+        get_atomic_double(&pl->changed_cells), clmrepr,
+        qlt_reprs[get_atomic_size_t_relaxed(&pl->quality_level)],
+        get_atomic_double(&pl->render_load),
+        out_reprs[get_atomic_size_t_relaxed(&pl->output_level)],
+        get_atomic_double(&pl->output_bps) / 1000.0, get_atomic_double(&pl->write_s) * 1000.0,
+        get_atomic_double(&pl->write_latency) * 1000.0
     );
+    if (length <= 0) {
+        return;
+    }
+
+    // With video, the writer puts the line in the same write as the next frame.
+    if (pl->mailbox != NULL) {
+        const size_t bsize = (size_t)length < sizeof(line) ? (size_t)length : sizeof(line) - 1;
+        mailbox_post_status(pl->mailbox, line, bsize);
+        return;
+    }
+    COORD c = {.X = 0, .Y = 0};
+    SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), c);
+    fprintf(stdout, "%s" VT_ERASE_LINE "\n", line);
+}
+
+/// @brief Ring index for `state_print()`. Informational, no ordering.
+static size_t ring_idx(
+    spsc_ring *ring,
+    bool       tail
+) {
+    if (ring == NULL) {
+        return 0;
+    }
+    return get_atomic_size_t_relaxed(tail ? &ring->tail : &ring->head);
 }
 
 void state_print(player *pl) {
-    AcquireSRWLockShared(&pl->srw_mclock);
-    const double main_clock = get_atomic_double(&pl->main_clock);
-    ReleaseSRWLockShared(&pl->srw_mclock);
+    ctrl_snapshot snap;
+    get_ctrl_snapshot(pl, &snap);
+    const double main_clock = get_main_clock(pl);
     COORD c = {.X = 0, .Y = 0};
     SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), c);
     fprintf(
@@ -550,17 +780,28 @@ void state_print(player *pl) {
         "AWRITE_IDX: %zu \n"
         "VREAD_IDX: %zu \n"
         "VWRITE_IDX: %zu \n"
+        "VRAW_QUEUED: %zu \n"
+        "SOURCE_FPS: %lf \n"
+        "VSKIPPED: %zu \n"
+        "VREPLACED: %zu \n"
+        "VSTILL: %zu \n"
+        "VCHANGED: %.1lf \n"
+        "VCULLED: %zu \n"
+        "VREUSED: %.2lf \n"
         "ACTIVE_THREADS: %u \n"
-        "DITHER_MODE: %u \n",
-        get_atomic_bool(&pl->shutdown) ? " TRUE" : "FALSE",
-        get_atomic_bool(&pl->playing) ? " TRUE" : "FALSE",
-        get_atomic_bool(&pl->looping) ? " TRUE" : "FALSE",
-        get_atomic_bool(&pl->invalidated) ? " TRUE" : "FALSE",
-        get_atomic_bool(&pl->muted) ? " TRUE" : "FALSE", main_clock, get_atomic_double(&pl->volume),
-        get_atomic_double(&pl->seek_speed), get_atomic_size_t(&pl->serial),
-        get_atomic_size_t(&pl->aread_idx), get_atomic_size_t(&pl->awrite_idx),
-        get_atomic_size_t(&pl->vread_idx), get_atomic_size_t(&pl->vwrite_idx),
-        (uint32_t)pl->active_threads, (uint32_t)pl->dither_mode
-
+        "DITHER_MODE: %u \n"
+        "FRAME_HASH: %016llx \n",
+        snap.shutdown ? " TRUE" : "FALSE", snap.playing ? " TRUE" : "FALSE",
+        snap.looping ? " TRUE" : "FALSE", snap.invalidated ? " TRUE" : "FALSE",
+        snap.muted ? " TRUE" : "FALSE", main_clock, snap.volume, snap.seek_speed, snap.serial,
+        ring_idx(pl->audio_ring, false), ring_idx(pl->audio_ring, true),
+        ring_idx(pl->video_ring, false), ring_idx(pl->video_ring, true),
+        ring_idx(pl->raw_ring, true) - ring_idx(pl->raw_ring, false), pl->media_mtdta->fps,
+        get_atomic_size_t_relaxed(&pl->skipped_frames),
+        get_atomic_size_t_relaxed(&pl->replaced_frames),
+        get_atomic_size_t_relaxed(&pl->still_frames), get_atomic_double(&pl->changed_cells),
+        get_atomic_size_t_relaxed(&pl->culled_frames), get_atomic_double(&pl->render_reuse),
+        (uint32_t)pl->active_threads,
+        (uint32_t)snap.dither_mode, (unsigned long long)get_atomic_size_t_relaxed(&pl->last_fhash)
     );
 }
\ No newline at end of file
@@ -1,196 +1,449 @@
 #include "lz4.h"
+#include "tl_dither.h"
 #include "tl_errors.h"
+#include "tl_mailbox.h"
 #include "tl_pch.h"
+#include "tl_pool.h"
+#include "tl_render.h"
+#include "tl_ring.h"
 #include "tl_types.h"
 #include "tl_utils.h"
 #include "tl_video.h"
 
-/// NOTE: This implementation (malloc in a loop ring buffer) works fine,
-/// but for future reference it would be better if you forgo
-/// frame compression, as the buffer is extremely tight now,
-/// for stability, and turn to a frame pool instead in that ring buffer.
-
 static tl_result get_new_ffmpeg_instance(
-    const double      clock_start,
-    const WCHAR      *media_path,
-    const con_bounds *bounds,
-    FILE            **ffmpeg_instance_out
+    const double       clock_start,
+    const media_mtdta *mtdta,
+    const size_t       px_wdth,
+    const size_t       px_ln,
+    FILE             **ffmpeg_instance_out
 );
 
 static tl_result get_raw_frame(
-    FILE             *ffmpeg_stream,
-    const con_bounds *bounds,
-    raw_frame       **f_out
+    FILE        *ffmpeg_stream,
+    const size_t px_wdth,
+    const size_t px_ln,
+    raw_frame  **f_out
 );
 
 static tl_result get_console_bounds(
     const media_mtdta *mtdta,
+    const double       scale,
     con_bounds       **out
 );
 
-static tl_result get_con_frame(
-    const con_bounds *bounds,
-    const double      ftime,
-    const size_t      fnum,
-    const dither_mode dmode,
-    void            **ext_data,
-    wchar_t          *wrk_buffer,
-    char             *comp_wbuffer,
-    raw_frame        *raw,
-    con_frame       **c_out
+static tl_result get_decode_size(
+    const media_mtdta *mtdta,
+    size_t            *px_wdth_out,
+    size_t            *px_ln_out
 );
 
-static wchar_t map_to_braille(uint8_t *map);
+static void govern_quality(
+    quality_gov *gov,
+    const double cost_s,
+    const double budget_s,
+    const bool   ordered
+);
 
-static tl_result apply_dither(
-    void            **ext_data,
-    const dither_mode dmode,
-    raw_frame        *rframe
+static void govern_output(
+    output_gov  *gov,
+    const double write_s,
+    const size_t bytes,
+    const double frame_intv,
+    const size_t target_bps
 );
 
-static tl_result clear_screen(HANDLE stdouth);
+static tl_result publish_job(
+    player       *pl,
+    serial_watch *watch,
+    frame_codec  *codec,
+    char         *comp_wbuffer,
+    render_job   *job
+);
 
-tl_result vpthread_exec(thread_data *data) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, data == NULL, TL_NULL_ARG, return excv);
-    player             *pl = data->player;
-    FILE               *ffmpeg_stream = NULL;
-    size_t              set_serial = 0;
-    double              prod_vclock = 0.0;
-    double              frametime_start = 0.0;
-    size_t              frame_number = 0;
-    static const size_t fbuffer_count = VBUFFER_BSIZE / sizeof(con_frame *);
-
-    raw_frame   *staging_frame = malloc(sizeof(raw_frame));
-    con_bounds  *bounds = malloc(sizeof(con_bounds));
-    wchar_t     *wrk_buffer = malloc(MAXIMUM_BUFFER_SIZE);
-    char        *compress_wbuffer = malloc(MAXIMUM_BUFFER_SIZE);
-    const WCHAR *media_path = data->player->media_mtdta->media_path;
+static void release_job(
+    render_job  *job,
+    render_job **free_jobs,
+    size_t      *free_count
+);
 
-    CHECK(excv, staging_frame == NULL, TL_ALLOC_FAILURE, return excv);
-    CHECK(excv, bounds == NULL, TL_ALLOC_FAILURE, return excv);
-    CHECK(excv, wrk_buffer == NULL, TL_ALLOC_FAILURE, return excv);
-    CHECK(excv, compress_wbuffer == NULL, TL_ALLOC_FAILURE, return excv);
+static tl_result encode_masks(
+    frame_codec   *codec,
+    const uint8_t *masks,
+    char          *comp_wbuffer,
+    con_frame     *frame
+);
 
-    staging_frame->data = malloc(MAXIMUM_BUFFER_SIZE);
-    CHECK(excv, staging_frame->data == NULL, TL_ALLOC_FAILURE, return excv);
+static tl_result decode_masks(
+    frame_codec     *codec,
+    const con_frame *frame,
+    const uint8_t  **masks_out
+);
 
-    staging_frame->flength = 0;
-    staging_frame->fwidth = 0;
+static tl_result post_clear(
+    player      *pl,
+    const size_t serial
+);
+
+static size_t compose_frame(
+    const con_frame *frame,
+    const uint8_t   *masks,
+    const color_mode clm,
+    char            *out,
+    const size_t     bsize
+);
+
+static void append_bytes(
+    char        *dst,
+    size_t      *length,
+    const void  *src,
+    const size_t bsize
+);
+
+static const bool qlt_ordered[QLT_LEVELS] = {
+#define X(lvl, str, ordered, scale, cost) ordered,
+    QUALITY_LIST
+#undef X
+};
+static const double qlt_scale[QLT_LEVELS] = {
+#define X(lvl, str, ordered, scale, cost) scale,
+    QUALITY_LIST
+#undef X
+};
+static const double qlt_cost[QLT_LEVELS] = {
+#define X(lvl, str, ordered, scale, cost) cost,
+    QUALITY_LIST
+#undef X
+};
+static const size_t out_rate_div[OUT_LEVELS] = {
+#define X(lvl, str, rate_div, scale) rate_div,
+    OUTPUT_LIST
+#undef X
+};
+static const double out_scale[OUT_LEVELS] = {
+#define X(lvl, str, rate_div, scale) scale,
+    OUTPUT_LIST
+#undef X
+};
+
+tl_result vrthread_exec(thread_data *data) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, data == NULL, TL_NULL_ARG, return excv);
+    player      *pl = data->player;
+    FILE        *ffmpeg_stream = NULL;
+    serial_watch watch = {.pl = pl, .serial = 0};
+    double       frametime_start = 0.0;
+    size_t       frame_number = 0;
+    size_t       dec_wdth = 0; // Decoding resolution. Independent of the console size.
+    size_t       dec_ln = 0;
+    dec_frame   *dframe = NULL;
+    const double frame_intv = (double)pl->media_mtdta->fps_den / (double)pl->media_mtdta->fps_num;
 
-    con_frame *frame = NULL;
     while (true) {
-        if (get_atomic_bool(&pl->shutdown)) {
+        if (get_atomic_bool(&pl->ctrl.shutdown)) {
             break;
         }
-        if (get_atomic_size_t(&pl->serial) != set_serial) {
+        if (serial_changed(&watch)) {
             if (ffmpeg_stream) {
                 _pclose(ffmpeg_stream);
                 ffmpeg_stream = NULL;
             }
-            set_atomic_size_t(&pl->vread_idx, 0);
-            set_atomic_size_t(&pl->vwrite_idx, 0);
-            for (size_t i = 0; i < fbuffer_count; ++i) {
-                destroy_conframe(&pl->video_rbuffer[i]);
-            }
-            set_serial = get_atomic_size_t(&pl->serial);
-            while (get_atomic_bool(&pl->invalidated)) {
-                if (get_atomic_size_t(&pl->serial) != set_serial ||
-                    get_atomic_bool(&pl->shutdown)) {
+            watch.serial = get_atomic_size_t(&pl->ctrl.serial);
+            while (get_atomic_bool(&pl->ctrl.invalidated)) {
+                if (serial_changed(&watch)) {
                     break;
                 }
-                Sleep(5);
+                wait_for_wake(pl, VIDEO_READ_EVENT_WAKE_HNDLE, INFINITE);
             }
-            if (get_atomic_size_t(&pl->serial) != set_serial) {
+            if (serial_changed(&watch)) {
                 continue;
             }
-            prod_vclock = get_atomic_double(&pl->main_clock);
-            frametime_start = prod_vclock;
+            frametime_start = get_atomic_double(&pl->main_clock);
             frame_number = 0;
         }
-        TRY(excv, get_console_bounds(data->player->media_mtdta, &bounds), goto epilogue);
-        TRY(excv, get_new_ffmpeg_instance(prod_vclock, media_path, bounds, &ffmpeg_stream),
+        TRY(excv, get_decode_size(pl->media_mtdta, &dec_wdth, &dec_ln), goto epilogue);
+        TRY(excv,
+            get_new_ffmpeg_instance(
+                frametime_start, pl->media_mtdta, dec_wdth, dec_ln, &ffmpeg_stream
+            ),
             goto epilogue);
 
+        // Only waits on a free frame, never on the converter itself. The pipe keeps draining
+        // while frames before it are being rendered.
         while (true) {
-            if (feof(ffmpeg_stream) || get_atomic_bool(&pl->shutdown) ||
-                get_atomic_size_t(&pl->serial) != set_serial) {
+            if (feof(ffmpeg_stream) || serial_changed(&watch)) {
                 break;
             }
-            const size_t nwrite_idx = (get_atomic_size_t(&pl->vwrite_idx) + 1) % fbuffer_count;
-            while (nwrite_idx == get_atomic_size_t(&pl->vread_idx)) {
-                if (get_atomic_bool(&pl->shutdown) ||
-                    get_atomic_size_t(&pl->serial) != set_serial) {
-                    break;
-                }
-                Sleep(5);
-            }
-            if (get_atomic_size_t(&pl->serial) != set_serial || get_atomic_bool(&pl->shutdown)) {
+            if (dframe == NULL &&
+                !spsc_pop_wait(pl->raw_free, &dframe, 1, serial_changed, &watch)) {
                 break;
             }
-            TRY(excv, get_raw_frame(ffmpeg_stream, bounds, &staging_frame), goto epilogue);
-            if (staging_frame->flength == 0 && staging_frame->fwidth == 0) {
+            raw_frame *raw = &dframe->frame;
+            TRY(excv, get_raw_frame(ffmpeg_stream, dec_wdth, dec_ln, &raw), goto epilogue);
+            if (raw->flength == 0 && raw->fwidth == 0) {
                 break;
             }
-            frame = NULL;
-            TRY(excv,
-                get_con_frame(
-                    bounds, frametime_start, frame_number, get_atomic_size_t(&pl->dither_mode),
-                    (void **)&(pl->ext_assets_ptr), wrk_buffer, compress_wbuffer, staging_frame,
-                    &frame
-                ),
-                goto epilogue);
+            // Exact, as ffmpeg outputs constant rate. See `get_new_ffmpeg_instance()`.
+            dframe->pts = frametime_start + (double)frame_number * frame_intv;
+            dframe->serial = watch.serial;
             frame_number++;
-            _InterlockedExchangePointer(
-                &pl->video_rbuffer[get_atomic_size_t(&pl->vwrite_idx)], frame
-            );
-            frame = NULL;
-            set_atomic_size_t(&pl->vwrite_idx, nwrite_idx);
+
+            // Can't fail, both rings together hold at most the whole pool.
+            spsc_push(pl->raw_ring, &dframe, 1);
+            dframe = NULL;
         }
         if (feof(ffmpeg_stream)) {
-            while (!get_atomic_bool(&pl->shutdown) &&
-                   get_atomic_size_t(&pl->serial) == set_serial) {
-                Sleep(1);
+            while (!serial_changed(&watch)) {
+                wait_for_wake(pl, VIDEO_READ_EVENT_WAKE_HNDLE, INFINITE);
             }
         }
         _pclose(ffmpeg_stream);
         ffmpeg_stream = NULL;
     }
 epilogue:
-    // destroy_player() takes care of final free-ing after all threads have been shut down to
-    // prevent use-after-free.
+    // Pooled frames are free-d by destroy_player().
     if (ffmpeg_stream) {
         _pclose(ffmpeg_stream);
         ffmpeg_stream = NULL;
     }
-    if (frame) {
-        destroy_conframe(&frame);
+    return excv;
+}
+
+tl_result vpthread_exec(thread_data *data) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, data == NULL, TL_NULL_ARG, return excv);
+    player      *pl = data->player;
+    serial_watch watch = {.pl = pl, .serial = 0};
+    size_t       set_layout = 0;
+    dec_frame   *dframe = NULL;
+    size_t       dispatch_seq = 0;
+    size_t       publish_seq = 0;
+    size_t       free_count = 0;
+    render_job   jobs[RENDER_JOBS];
+    render_job  *free_jobs[RENDER_JOBS];
+    render_job  *inflight[VRAW_FRAMES]; // Submitted jobs by `seq % VRAW_FRAMES`, until published.
+    render_job  *ref = NULL;            // Last published job, new jobs reuse cells from it.
+    const double frame_intv = (double)pl->media_mtdta->fps_den / (double)pl->media_mtdta->fps_num;
+
+    quality_gov   gov = {.level = QLT_FULL, .load = 0.0, .changed_at = mono_time(), .culled = 0};
+    double        reuse = 0.0; // EWMA of the share of cells reused.
+    quality_level set_level = QLT_FULL; // Levels `bounds` were computed for.
+    output_level  set_out_level = OUT_FULL;
+
+    con_bounds  *bounds = malloc(sizeof(con_bounds));
+    char        *compress_wbuffer = malloc(MAXIMUM_BUFFER_SIZE);
+    frame_codec *codec = NULL;
+    renderer    *rd = NULL;
+
+    // Every job in flight holds a decoded frame, so no more than the pool can ever be.
+    for (size_t i = 0; i < RENDER_JOBS; ++i) {
+        jobs[i].dframe = NULL;
+        jobs[i].ref = NULL;
+        jobs[i].pins = 0;
+        jobs[i].held = false;
+        jobs[i].masks = malloc(MAXIMUM_BUFFER_SIZE / BRAILLE_DOTS_PER_CHAR);
+        jobs[i].luma = malloc(MAXIMUM_BUFFER_SIZE);
+        free_jobs[free_count++] = &jobs[i];
+    }
+    for (size_t i = 0; i < VRAW_FRAMES; ++i) {
+        inflight[i] = NULL;
+    }
+    for (size_t i = 0; i < RENDER_JOBS; ++i) {
+        CHECK(excv, jobs[i].masks == NULL, TL_ALLOC_FAILURE, goto epilogue);
+        CHECK(excv, jobs[i].luma == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    }
+    CHECK(excv, bounds == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    CHECK(excv, compress_wbuffer == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    TRY(excv, create_frame_codec(&codec), goto epilogue);
+    TRY(excv,
+        create_renderer(pl->pool, pl->blue_tile, pl->ev_hndles[VIDEO_PROD_EVENT_WAKE_HNDLE], &rd),
+        goto epilogue);
+
+    set_layout = get_atomic_size_t(&pl->ctrl.layout);
+    TRY(excv, get_console_bounds(pl->media_mtdta, 1.0, &bounds), goto epilogue);
+
+    // Jobs render in parallel, frames are due one interval apart. Each one gets as many intervals
+    // as there can be jobs rendering at once.
+    const size_t parallel_jobs =
+        pool_worker_count(pl->pool) < VRAW_FRAMES ? pool_worker_count(pl->pool) : VRAW_FRAMES;
+    const double frame_budget = frame_intv * (double)parallel_jobs;
+
+    while (true) {
+        if (get_atomic_bool(&pl->ctrl.shutdown)) {
+            break;
+        }
+        if (serial_changed(&watch)) {
+            // Stale frames are dropped by the consumer when it flushes up to the mark.
+            watch.serial = get_atomic_size_t(&pl->ctrl.serial);
+            spsc_mark(pl->video_ring, watch.serial);
+
+            // The consumer drops its reference on a serial change. Restart on a keyframe.
+            codec->ref_cells = 0;
+            if (ref != NULL) {
+                ref->held = false;
+                release_job(ref, free_jobs, &free_count);
+                ref = NULL;
+            }
+        }
+        bool          progressed = false;
+        ctrl_snapshot snap;
+        get_ctrl_snapshot(pl, &snap);
+        const double clock = get_present_clock(pl, &snap);
+
+        // Temporal encoding needs frames in order, jobs are published strictly by `seq`.
+        // Decoded frames go back to the reader as soon as their job is.
+        while (publish_seq != dispatch_seq && render_done(inflight[publish_seq % VRAW_FRAMES])) {
+            render_job *job = inflight[publish_seq % VRAW_FRAMES];
+            inflight[publish_seq % VRAW_FRAMES] = NULL;
+            publish_seq++;
+            spsc_push(pl->raw_free, &job->dframe, 1);
+            job->dframe = NULL;
+            progressed = true;
+            if (job->ref != NULL) {
+                job->ref->pins--;
+                release_job(job->ref, free_jobs, &free_count);
+                job->ref = NULL;
+            }
+            const bool good =
+                job->excv == TL_SUCCESS && job->supported && job->serial == watch.serial;
+            if (good) {
+                const double cells = (double)(job->bounds.cell_ln * job->bounds.cell_wdth);
+                reuse += GOV_EWMA_ALPHA * ((double)job->reused_cells / cells - reuse);
+                govern_quality(
+                    &gov, job->cost_s, frame_budget,
+                    dither_ordered((dither_mode)get_atomic_size_t(&pl->ctrl.dither_mode))
+                );
+                set_atomic_size_t(&pl->quality_level, gov.level);
+                set_atomic_double(&pl->render_load, gov.load);
+                set_atomic_double(&pl->render_reuse, reuse);
+            }
+            TRY(excv, publish_job(pl, &watch, codec, compress_wbuffer, job), goto epilogue);
+
+            // Published in order, so this is the newest frame there is to reuse cells from.
+            if (good && dither_reusable(job->dmode, job->stable)) {
+                if (ref != NULL) {
+                    ref->held = false;
+                    release_job(ref, free_jobs, &free_count);
+                }
+                ref = job;
+                ref->held = true;
+            } else {
+                release_job(job, free_jobs, &free_count);
+            }
+        }
+
+        while (free_count > 0) {
+            if (dframe == NULL && spsc_pop(pl->raw_ring, &dframe, 1) == 0) {
+                break;
+            }
+            if (dframe->serial != watch.serial) {
+                // Frames the reader decoded past a serial change this thread hasn't caught up
+                // with yet are kept for after it does. Older ones are stale.
+                if (serial_changed(&watch)) {
+                    break;
+                }
+                spsc_push(pl->raw_free, &dframe, 1);
+                dframe = NULL;
+                progressed = true;
+                continue;
+            }
+
+            // The frame after it is already due and decoded, so this one would only get skipped
+            // by the consumer. Never culls the newest frame, a slow reader still gets something
+            // on screen.
+            if (dframe->pts + frame_intv <= clock && spsc_size(pl->raw_ring) > 0) {
+                add_atomic_size_t(&pl->culled_frames, 1);
+                gov.culled++;
+                spsc_push(pl->raw_free, &dframe, 1);
+                dframe = NULL;
+                progressed = true;
+                continue;
+            }
+
+            // Resizes and governor steps only change where the decoded frames get scaled to. Of
+            // both governors' scales, the smaller one wins.
+            const size_t       layout = get_atomic_size_t(&pl->ctrl.layout);
+            const output_level out_level = (output_level)get_atomic_size_t(&pl->output_level);
+            if (layout != set_layout || gov.level != set_level || out_level != set_out_level) {
+                const double scale = qlt_scale[gov.level] < out_scale[out_level]
+                                         ? qlt_scale[gov.level]
+                                         : out_scale[out_level];
+                TRY(excv, get_console_bounds(pl->media_mtdta, scale, &bounds), goto epilogue);
+                set_layout = layout;
+                set_level = gov.level;
+                set_out_level = out_level;
+            }
+            render_job *job = free_jobs[--free_count];
+            job->dframe = dframe;
+            job->bounds = *bounds;
+            job->dmode = (dither_mode)get_atomic_size_t(&pl->ctrl.dither_mode);
+            if (qlt_ordered[gov.level] && !dither_ordered(job->dmode)) {
+                job->dmode = DTH_BAYER_8X8;
+            }
+            job->stable = get_atomic_bool(&pl->ctrl.stable_dots);
+            job->seq = dispatch_seq++;
+            job->serial = watch.serial;
+            job->layout = set_layout;
+            job->pts = dframe->pts;
+
+            // Only jobs that can reuse cells pin the reference, the others never read it.
+            job->ref = dither_reusable(job->dmode, job->stable) ? ref : NULL;
+            if (job->ref != NULL) {
+                job->ref->pins++;
+            }
+            inflight[job->seq % VRAW_FRAMES] = job;
+            render_submit(rd, job);
+            dframe = NULL;
+            progressed = true;
+        }
+        if (!progressed && !serial_changed(&watch)) {
+            wait_for_wake(pl, VIDEO_PROD_EVENT_WAKE_HNDLE, INFINITE);
+        }
+    }
+epilogue:
+    // The pool outlives this thread, jobs still on it have to finish before their masks and
+    // the renderer go. Completion signals the wake event, so none of the waits get lost.
+    for (; publish_seq != dispatch_seq; ++publish_seq) {
+        while (!render_done(inflight[publish_seq % VRAW_FRAMES])) {
+            wait_for_wake(pl, VIDEO_PROD_EVENT_WAKE_HNDLE, INFINITE);
+        }
+    }
+
+    // destroy_player() takes care of final free-ing after all threads have been shut down to
+    // prevent use-after-free.
+    destroy_renderer(&rd);
+    for (size_t i = 0; i < RENDER_JOBS; ++i) {
+        free(jobs[i].masks);
+        free(jobs[i].luma);
     }
-    destroy_rawframe(&staging_frame);
     free(bounds);
-    free(wrk_buffer);
     free(compress_wbuffer);
+    destroy_frame_codec(&codec);
     return excv;
 }
 
 static tl_result get_new_ffmpeg_instance(
-    const double      clock_start,
-    const WCHAR      *media_path,
-    const con_bounds *bounds,
-    FILE            **ffmpeg_instance_out
+    const double       clock_start,
+    const media_mtdta *mtdta,
+    const size_t       px_wdth,
+    const size_t       px_ln,
+    FILE             **ffmpeg_instance_out
 ) {
     tl_result excv = TL_SUCCESS;
     CHECK(excv, clock_start < 0.0, TL_INVALID_ARG, return excv);
-    CHECK(excv, media_path == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, bounds == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, mtdta == NULL || mtdta->media_path == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, px_wdth == 0 || px_ln == 0, TL_INVALID_ARG, return excv);
     CHECK(excv, ffmpeg_instance_out == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, *ffmpeg_instance_out != NULL, TL_ALREADY_INITIALIZED, return excv);
     wchar_t cmd[GBUFFER_BSIZE];
 
+    // The source's own rate, as an exact fraction. Raw video carries no timestamps, so the output
+    // is constant rate on purpose and frame times follow from the frame count. Constant rate
+    // sources come through untouched. Variable rate ones get frames duplicated or dropped onto
+    // the grid, so their times are only ever off by under a frame.
     int swret = swprintf_s(
         cmd, GBUFFER_BSIZE,
-        L"ffmpeg -v quiet -ss %lf -i \"%ls\" -an -s %zux%zu -f rawvideo -r %u -pix_fmt gray -",
-        clock_start, media_path, bounds->log_wdth, bounds->log_ln, V_FPS
+        L"ffmpeg -v quiet -ss %lf -i \"%ls\" -an -s %zux%zu -f rawvideo -r %u/%u -pix_fmt gray -",
+        clock_start, mtdta->media_path, px_wdth, px_ln, mtdta->fps_num, mtdta->fps_den
     );
     CHECK(excv, swret < 0, TL_FORMAT_FAILURE, return excv);
 
@@ -200,19 +453,18 @@ static tl_result get_new_ffmpeg_instance(
 }
 
 static tl_result get_raw_frame(
-    FILE             *ffmpeg_stream,
-    const con_bounds *bounds,
-    raw_frame       **f_out
+    FILE        *ffmpeg_stream,
+    const size_t px_wdth,
+    const size_t px_ln,
+    raw_frame  **f_out
 ) {
     tl_result excv = TL_SUCCESS;
     CHECK(excv, ffmpeg_stream == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, bounds == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, f_out == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, *f_out == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, (*f_out)->data == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, px_wdth * px_ln > MAXIMUM_BUFFER_SIZE, TL_INVALID_ARG, return excv);
     raw_frame *rf = *f_out;
-    size_t     px_wdth = bounds->log_wdth;
-    size_t     px_ln = bounds->log_ln;
     raw_frame *out = *f_out;
 
     size_t px_ret = fread(out->data, sizeof(uint8_t), px_wdth * px_ln, ffmpeg_stream);
@@ -226,94 +478,279 @@ static tl_result get_raw_frame(
     CHECK(excv, px_ret != px_wdth * px_ln, TL_INCOMPLETE_DATA, return excv);
     out->flength = px_ln;
     out->fwidth = px_wdth;
+    out->tiled = false;
     return excv;
 }
 
-static tl_result get_con_frame(
-    const con_bounds *bounds,
-    const double      ftime,
-    const size_t      fnum,
-    const dither_mode dmode,
-    void            **ext_data,
-    wchar_t          *wrk_buffer,
-    char             *comp_wbuffer,
-    raw_frame        *raw,
-    con_frame       **c_out
+/// @brief Render cost of a level relative to full quality, for the selected mode. Modes that are
+/// ordered already only get cheaper from the resolution steps.
+static double level_cost(
+    const quality_level level,
+    const bool          ordered
 ) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, raw == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, bounds == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, c_out == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, *c_out != NULL, TL_ALREADY_INITIALIZED, return excv);
-    if (bounds->abs_conln * bounds->abs_conwdth * sizeof(wchar_t) > MAXIMUM_BUFFER_SIZE ||
-        LZ4_compressBound((int)(bounds->cell_ln * bounds->cell_wdth)) > MAXIMUM_BUFFER_SIZE) {
-        // Unsupported resolution. `vcthread` will process NULL `con_frame*`s as empty frames.
-        return excv;
+    return ordered && qlt_ordered[level] ? qlt_cost[level] / qlt_cost[QLT_ORDERED]
+                                         : qlt_cost[level];
+}
+
+/// @brief Folds a rendered frame's cost into the load, then steps quality if it's due.
+/// Stepping down is quick and also happens on culls, stepping up waits for lasting headroom.
+/// With an ordered mode selected, `QLT_ORDERED` would change nothing and gets stepped over.
+static void govern_quality(
+    quality_gov *gov,
+    const double cost_s,
+    const double budget_s,
+    const bool   ordered
+) {
+    gov->load += GOV_EWMA_ALPHA * (cost_s / budget_s - gov->load);
+    const double  now = mono_time();
+    const double  held = now - gov->changed_at;
+    const bool    behind = gov->culled > 0;
+    quality_level next = gov->level;
+    gov->culled = 0;
+    quality_level down = gov->level + 1;
+    quality_level up = gov->level > QLT_FULL ? gov->level - 1 : QLT_FULL;
+    if (ordered && down == QLT_ORDERED) {
+        down++;
     }
-    *c_out = malloc(sizeof(con_frame));
-    CHECK(excv, *c_out == NULL, TL_ALLOC_FAILURE, return excv);
-    con_frame *cframe = *c_out;
-    cframe->flength = bounds->cell_ln;
-    cframe->fwidth = bounds->cell_wdth;
-    cframe->uncompressed_bsize = cframe->flength * cframe->fwidth * sizeof(wchar_t);
-    cframe->x_start = bounds->start_col;
-    cframe->y_start = bounds->start_row;
-
-    TRY(excv, apply_dither(ext_data, dmode, raw), goto epilogue);
-
-    const size_t total_chars = cframe->flength * cframe->fwidth;
-    const size_t alignment_matrix[BRAILLE_DOTS_PER_CHAR] = {
-        0,
-        1,
-        bounds->log_wdth,
-        bounds->log_wdth + 1,
-        bounds->log_wdth * 2,
-        bounds->log_wdth * 2 + 1,
-        bounds->log_wdth * 3,
-        bounds->log_wdth * 3 + 1,
-    };
-
-    const size_t total_px = bounds->log_ln * bounds->log_wdth;
-    size_t       starting_px_idx = 0;
-    uint8_t      bitmap[BRAILLE_DOTS_PER_CHAR] = {0, 0, 0, 0, 0, 0, 0, 0};
-    size_t       data_idx = 0;
-    size_t       px_idx = 0;
-
-    for (size_t ych = 0; ych < bounds->cell_ln; ++ych) {
-        for (size_t xch = 0; xch < bounds->cell_wdth; ++xch) {
-            starting_px_idx =
-                ych * BRAILLE_CHAR_DOT_LN * bounds->log_wdth + xch * BRAILLE_CHAR_DOT_WDTH;
-            for (size_t bdot_i = 0; bdot_i < BRAILLE_DOTS_PER_CHAR; ++bdot_i) {
-                px_idx = starting_px_idx + alignment_matrix[bdot_i];
-                bitmap[bdot_i] = raw->data[px_idx];
-            }
-            wchar_t braille_char = map_to_braille(bitmap);
-            wrk_buffer[data_idx] = braille_char;
-            data_idx++;
+    if (ordered && up == QLT_ORDERED) {
+        up--;
+    }
+    const double cost = level_cost(gov->level, ordered);
+    if ((gov->load > GOV_DOWN_LOAD || behind) && held >= GOV_DOWN_HOLD_S && down < QLT_LEVELS) {
+        next = down;
+    } else if (gov->level > QLT_FULL && held >= GOV_UP_HOLD_S &&
+               gov->load * level_cost(up, ordered) / cost < GOV_UP_LOAD) {
+        next = up;
+    }
+    if (next == gov->level) {
+        return;
+    }
+
+    // Rescaled to what the new level is expected to cost, rather than waiting for the average
+    // to catch up.
+    gov->load *= level_cost(next, ordered) / cost;
+    gov->level = next;
+    gov->changed_at = now;
+}
+
+/// @brief Folds a frame write into the averages, then steps output if it's due.
+/// Steps down when writes take up too much of the time between written frames, or when the
+/// bandwidth goes over the target. Same hold times as the quality governor.
+static void govern_output(
+    output_gov  *gov,
+    const double write_s,
+    const size_t bytes,
+    const double frame_intv,
+    const size_t target_bps
+) {
+    gov->write_s += OUT_EWMA_ALPHA * (write_s - gov->write_s);
+    gov->bytes += OUT_EWMA_ALPHA * ((double)bytes - gov->bytes);
+
+    // Bytes scale with the cell count, the time they have with the rate divisor.
+    double cost[OUT_LEVELS];
+    for (size_t i = 0; i < OUT_LEVELS; ++i) {
+        cost[i] = out_scale[i] * out_scale[i] / (double)out_rate_div[i];
+    }
+    const double slot_s = frame_intv * (double)out_rate_div[gov->level];
+    const double share = gov->write_s / slot_s;
+    const double bps = gov->bytes / slot_s;
+    const double target = target_bps != 0 ? (double)target_bps : DBL_MAX;
+    const double now = mono_time();
+    const double held = now - gov->changed_at;
+    output_level next = gov->level;
+    if ((share > OUT_DOWN_SHARE || bps > target) && held >= GOV_DOWN_HOLD_S &&
+        gov->level + 1 < OUT_LEVELS) {
+        next = gov->level + 1;
+    } else if (gov->level > OUT_FULL && held >= GOV_UP_HOLD_S) {
+        const double up = cost[gov->level - 1] / cost[gov->level];
+        if (share * up < OUT_UP_SHARE && bps * up < target * OUT_UP_SHARE / OUT_DOWN_SHARE) {
+            next = gov->level - 1;
         }
     }
+    if (next == gov->level) {
+        return;
+    }
 
-    int lz4_compressed_size = LZ4_compress_default(
-        (char *)wrk_buffer, comp_wbuffer, (int)cframe->uncompressed_bsize, MAXIMUM_BUFFER_SIZE
-    );
-    CHECK(excv, lz4_compressed_size == 0, TL_COMPRESS_ERR, goto epilogue);
-    cframe->compressed_bsize = (size_t)lz4_compressed_size;
-    cframe->compressed_data = malloc(cframe->compressed_bsize);
-    cframe->pts = ftime + (fnum * (1 / (double)V_FPS));
-    memcpy(cframe->compressed_data, comp_wbuffer, cframe->compressed_bsize);
+    // Time and bytes per frame only follow the cell count, rate changes don't touch them.
+    const double cells = (out_scale[next] * out_scale[next]) /
+                         (out_scale[gov->level] * out_scale[gov->level]);
+    gov->write_s *= cells;
+    gov->bytes *= cells;
+    gov->level = next;
+    gov->changed_at = now;
+}
+
+/// @brief Returns a job to the free list, unless it's still the reference or referenced.
+static void release_job(
+    render_job  *job,
+    render_job **free_jobs,
+    size_t      *free_count
+) {
+    if (job->held || job->pins > 0) {
+        return;
+    }
+    free_jobs[(*free_count)++] = job;
+}
+
+static tl_result publish_job(
+    player       *pl,
+    serial_watch *watch,
+    frame_codec  *codec,
+    char         *comp_wbuffer,
+    render_job   *job
+) {
+    tl_result excv = job->excv;
+    CHECK(excv, excv != TL_SUCCESS, job->excv, return excv);
+    if (job->serial != watch->serial) {
+        // Rendered before a seek.
+        return excv;
+    }
+    con_frame *frame = NULL;
+    if (job->supported) {
+        frame = malloc(sizeof(con_frame));
+        CHECK(excv, frame == NULL, TL_ALLOC_FAILURE, return excv);
+        frame->compressed_data = NULL;
+        frame->flength = job->bounds.cell_ln;
+        frame->fwidth = job->bounds.cell_wdth;
+        frame->uncompressed_bsize = frame->flength * frame->fwidth; // One mask per cell.
+        frame->x_start = job->bounds.start_col;
+        frame->y_start = job->bounds.start_row;
+        frame->pts = job->pts;
+        frame->hash = job->hash;
+        frame->layout = job->layout;
+        TRY(excv, encode_masks(codec, job->masks, comp_wbuffer, frame), goto epilogue);
+        const double changed = get_atomic_double(&pl->changed_cells);
+        set_atomic_double(
+            &pl->changed_cells, changed + GOV_EWMA_ALPHA * ((double)frame->changed_cells - changed)
+        );
+    } else {
+        // Unsupported resolution. `vcthread` will process NULL `con_frame*`s as empty frames.
+        codec->ref_cells = 0;
+    }
 
+    // Blocks while the queue is full. Stale frames left behind on a cancel are dropped by the
+    // consumer's flush.
+    if (!push_conframe(pl->video_ring, frame, serial_changed, watch)) {
+        destroy_conframe(&frame);
+    }
+    frame = NULL;
 epilogue:
     if (excv != TL_SUCCESS) {
-        destroy_conframe(&cframe);
+        destroy_conframe(&frame);
+    }
+    return excv;
+}
+
+/// Consecutive frames mostly share their masks. Delta frames hold `masks ^ ref`, which is mostly
+/// zeroes and compresses far better than the masks themselves.
+static tl_result encode_masks(
+    frame_codec   *codec,
+    const uint8_t *masks,
+    char          *comp_wbuffer,
+    con_frame     *frame
+) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t cells = frame->flength * frame->fwidth;
+
+    // Counted for the presenter, which leaves still scenes alone.
+    frame->changed_cells = cells;
+    if (codec->ref_cells == cells) {
+        frame->changed_cells = 0;
+        for (size_t i = 0; i < cells; ++i) {
+            frame->changed_cells += codec->ref[i] != masks[i];
+        }
+    }
+
+    // Dimension changes (resizes) always start over on a keyframe.
+    frame->keyframe = codec->ref_cells != cells || codec->since_key + 1 >= V_KEYFRAME_INTERVAL;
+    codec->since_key = frame->keyframe ? 0 : codec->since_key + 1;
+    if (!frame->keyframe) {
+        // The reference turns into the delta, `masks` become the next reference below.
+        for (size_t i = 0; i < cells; ++i) {
+            codec->ref[i] ^= masks[i];
+        }
+    }
+    const uint8_t *src = frame->keyframe ? masks : codec->ref;
+    int            lz4_compressed_size = LZ4_compress_default(
+        (const char *)src, comp_wbuffer, (int)frame->uncompressed_bsize, MAXIMUM_BUFFER_SIZE
+    );
+    memcpy(codec->ref, masks, cells);
+    codec->ref_cells = cells;
+
+    CHECK(excv, lz4_compressed_size == 0, TL_COMPRESS_ERR, return excv);
+    frame->compressed_bsize = (size_t)lz4_compressed_size;
+    frame->compressed_data = malloc(frame->compressed_bsize);
+    CHECK(excv, frame->compressed_data == NULL, TL_ALLOC_FAILURE, return excv);
+    memcpy(frame->compressed_data, comp_wbuffer, frame->compressed_bsize);
+    return excv;
+}
+
+static tl_result decode_masks(
+    frame_codec     *codec,
+    const con_frame *frame,
+    const uint8_t  **masks_out
+) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t cells = frame->flength * frame->fwidth;
+    *masks_out = NULL;
+
+    // A delta without its reference. Nothing to show until the next keyframe.
+    if (!frame->keyframe && codec->ref_cells != cells) {
+        return excv;
+    }
+    uint8_t *dst = frame->keyframe ? codec->ref : codec->cur;
+    int      lz4_dret =
+        LZ4_decompress_fast(frame->compressed_data, (char *)dst, (int)frame->uncompressed_bsize);
+    CHECK(excv, lz4_dret <= 0, TL_COMPRESS_ERR, return excv);
+    if (!frame->keyframe) {
+        for (size_t i = 0; i < cells; ++i) {
+            codec->ref[i] ^= codec->cur[i];
+        }
     }
+    codec->ref_cells = cells;
+    *masks_out = codec->ref;
+    return excv;
+}
+
+/// Decoding happens once, at the largest size the console can be resized to, capped by the
+/// source resolution. Every console size after that is a downscale of the same frames.
+static tl_result get_decode_size(
+    const media_mtdta *mtdta,
+    size_t            *px_wdth_out,
+    size_t            *px_ln_out
+) {
+    tl_result excv = TL_SUCCESS;
+    CHECK(excv, mtdta == NULL, TL_NULL_ARG, return excv);
+    CHECK(excv, px_wdth_out == NULL || px_ln_out == NULL, TL_NULL_ARG, return excv);
+    HANDLE stdouth = GetStdHandle(STD_OUTPUT_HANDLE);
+    CHECK(excv, stdouth == NULL || stdouth == INVALID_HANDLE_VALUE, TL_OS_ERR, return excv);
+    const COORD largest = GetLargestConsoleWindowSize(stdouth);
+    CHECK(excv, largest.X == 0 || largest.Y == 0, TL_CONSOLE_ERR, return excv);
+
+    double max_wdth = (double)(largest.X * BRAILLE_CHAR_DOT_WDTH);
+    double max_ln = (double)(largest.Y * BRAILLE_CHAR_DOT_LN);
+    max_wdth = fmin(max_wdth, fmin((double)mtdta->width, MAXIMUM_RESOLUTION_WIDTH));
+    max_ln = fmin(max_ln, fmin((double)mtdta->height, MAXIMUM_RESOLUTION_HEIGHT));
+
+    const double v_aspect = (double)mtdta->width / (double)mtdta->height;
+    double       wdth = max_wdth;
+    double       ln = wdth / v_aspect;
+    if (ln > max_ln) {
+        ln = max_ln;
+        wdth = ln * v_aspect;
+    }
+    *px_wdth_out = wdth < 1.0 ? 1 : (size_t)wdth;
+    *px_ln_out = ln < 1.0 ? 1 : (size_t)ln;
     return excv;
 }
 
 static tl_result get_console_bounds(
     const media_mtdta *mtdta,
+    const double       scale,
     con_bounds       **out
 ) {
     tl_result excv = TL_SUCCESS;
+    CHECK(excv, scale <= 0.0 || scale > 1.0, TL_INVALID_ARG, return excv);
     CHECK(excv, out == NULL, TL_NULL_ARG, return excv);
     CHECK(excv, *out == NULL, TL_INVALID_ARG, return excv);
     CONSOLE_SCREEN_BUFFER_INFO csbi;
@@ -341,6 +778,12 @@ static tl_result get_console_bounds(
         b->cell_wdth = (size_t)(((double)b->cell_ln / char_pixel_aspect) * v_aspect);
     }
 
+    // Reduced resolution, for the quality governor. Stays centered.
+    if (scale < 1.0) {
+        b->cell_ln = (size_t)((double)b->cell_ln * scale);
+        b->cell_wdth = (size_t)((double)b->cell_wdth * scale);
+    }
+
     // Ensure the pixel dimensions are an even multiple of the braille character dots.
     if (b->log_wdth % BRAILLE_CHAR_DOT_WDTH != 0) {
         b->log_wdth -= (b->log_wdth % BRAILLE_CHAR_DOT_WDTH);
@@ -357,517 +800,324 @@ static tl_result get_console_bounds(
     return excv;
 }
 
-static wchar_t map_to_braille(uint8_t *map) {
-    static const wchar_t main_offset = 0x2800;
-    static const uint8_t alignment_shifts[BRAILLE_DOTS_PER_CHAR] = {0, 3, 1, 4, 2, 5, 6, 7};
-    wchar_t              bchar = main_offset;
-    uint8_t              set = 0;
-    for (size_t i = 0; i < BRAILLE_DOTS_PER_CHAR; ++i) {
-        set = map[i] < 128 ? 0 : 1;
-        bchar |= (set << alignment_shifts[i]);
-    }
-    return bchar;
-}
-
 tl_result vcthread_exec(thread_data *data) {
-    static const size_t vbuffer_frames = VBUFFER_BSIZE / sizeof(con_frame *);
-    static const COORD  hm = {.X = 0, .Y = 1};
-
-    tl_result   excv = TL_SUCCESS;
-    player     *pl = data->player;
-    size_t      set_serial = 0;
-    bool        debug_print = false;
-    con_frame **fbuf = pl->video_rbuffer;
-
-    CHAR_INFO *conbuf = NULL;
-    SMALL_RECT write_region = {.Bottom = 0, .Left = 0, .Right = 0, .Top = 0};
-    COORD      conbuf_size = {.X = 0, .Y = 0};
-    HANDLE     stdouth = GetStdHandle(STD_OUTPUT_HANDLE);
-    CHECK(excv, stdouth == NULL || stdouth == INVALID_HANDLE_VALUE, TL_OS_ERR, return excv);
-
-    wchar_t *uncomp_fbuffer = malloc(MAXIMUM_BUFFER_SIZE);
-    CHECK(excv, uncomp_fbuffer == NULL, TL_ALLOC_FAILURE, return excv);
-
+    tl_result      excv = TL_SUCCESS;
+    player        *pl = data->player;
+    size_t         set_serial = 0;
+    bool           debug_print = false;
+    con_frame     *frame = NULL; // Taken from the queue, waiting for its presentation time.
+    const uint8_t *masks = NULL; // Decoded masks of `frame`.
+    frame_codec   *codec = NULL;
+    HANDLE         timer = create_deadline_timer(); // Falls back to coarse waits if NULL.
+    const double   frame_intv = (double)pl->media_mtdta->fps_den / pl->media_mtdta->fps_num;
+    double         shown_pts = -DBL_MAX; // PTS of the last frame posted.
+    uint64_t       shown_hash = 0;
+    color_mode     shown_clm = CLM_WHITE;
+    size_t         still_run = 0;     // Alike frames in a row, see `V_STILL_CELL_DIV`.
+    size_t         unshown_cells = 0; // Changed cells since the last frame posted. Can overcount.
+
+    // Where the last frame posted went. Frames going anywhere else clear the screen first.
+    // 0 `shown_ln` when nothing's on screen.
+    size_t shown_ln = 0;
+    size_t shown_wdth = 0;
+    size_t shown_row = 0;
+    size_t shown_col = 0;
+
+    TRY(excv, create_frame_codec(&codec), return excv);
+
+    ctrl_snapshot snap;
     while (true) {
-        const bool   shutdown = get_atomic_bool(&pl->shutdown);
-        const bool   playback = get_atomic_bool(&pl->playing);
-        const size_t cserial = get_atomic_size_t(&pl->serial);
-        const bool   ndebug_print = get_atomic_bool(&pl->debug_print);
+        get_ctrl_snapshot(pl, &snap);
+        const bool   shutdown = snap.shutdown;
+        const bool   playback = snap.playing;
+        const size_t cserial = snap.serial;
+        const bool   ndebug_print = snap.debug_print;
         if (shutdown) {
             break;
         }
 
         // Just quickly clears left behind status prints.
         if (!ndebug_print && debug_print) {
-            TRY(excv, clear_screen(stdouth), goto epilogue);
+            TRY(excv, post_clear(pl, set_serial), goto epilogue);
+            shown_ln = 0;
         }
         debug_print = ndebug_print;
 
         if (cserial != set_serial) {
-            set_serial = cserial;
+            destroy_conframe(&frame);
+            codec->ref_cells = 0;
 
             // Prevents resetting again and again while seeking.
-            while (get_atomic_bool(&pl->invalidated)) {
-                if (shutdown || set_serial != cserial) {
-                    break;
-                }
-                Sleep(5);
-            }
-            if (get_atomic_size_t(&pl->serial) != set_serial) {
+            if (snap.invalidated) {
+                wait_for_wake(pl, VIDEO_EVENT_WAKE_HNDLE, INFINITE);
                 continue;
             }
-            // Removes left-behind artifacts upon resizing.
-            TRY(excv, clear_screen(stdouth), goto epilogue);
+            set_serial = cserial;
+            shown_pts = -DBL_MAX;
+            // Starts the new serial on a clean screen.
+            TRY(excv, post_clear(pl, set_serial), goto epilogue);
+            shown_ln = 0;
         }
         if (!playback) {
-            Sleep(10);
+            wait_for_wake(pl, VIDEO_EVENT_WAKE_HNDLE, INFINITE);
             continue;
         }
+        if (frame == NULL) {
+            // Until the producer has caught up with the serial, whatever is queued is stale.
+            if (!spsc_flush(pl->video_ring, set_serial) || !pop_conframe(pl->video_ring, &frame)) {
+                wait_for_wake(pl, VIDEO_EVENT_WAKE_HNDLE, INFINITE);
+                continue;
+            }
+            if (frame == NULL) {
+                codec->ref_cells = 0;
+                TRY(excv, post_clear(pl, set_serial), goto epilogue);
+                shown_ln = 0;
+                continue;
+            }
 
-        const size_t vread = get_atomic_size_t(&pl->vread_idx);
-        const size_t vwrite = get_atomic_size_t(&pl->vwrite_idx);
-        const size_t nvread = (vread + 1) % vbuffer_frames;
+            // Decoded as soon as it's taken, late frames included, so that the next delta frame
+            // has its reference.
+            TRY(excv, decode_masks(codec, frame, &masks), goto epilogue);
+            if (masks == NULL) {
+                destroy_conframe(&frame);
+                continue;
+            }
 
-        if (vread == vwrite) {
-            Sleep(5);
-            continue;
+            // Every frame's changes count, including those of frames that don't get shown.
+            const size_t alike_cells = frame->flength * frame->fwidth / V_STILL_CELL_DIV;
+            still_run = frame->changed_cells <= alike_cells ? still_run + 1 : 0;
+            unshown_cells += frame->changed_cells;
         }
-        if (fbuf[vread] == NULL) {
-            clear_screen(stdouth);
-            set_atomic_size_t(&pl->vread_idx, nvread);
-            Sleep(5);
+        const double clock = get_present_clock(pl, &snap);
+        const double drift = clock - frame->pts;
+
+        // Sized for a console layout that's gone. Already decoded, nothing else to do.
+        if (frame->layout != snap.layout) {
+            destroy_conframe(&frame);
             continue;
         }
 
-        // We need to take ownership of frame
-        const con_frame *frame = _InterlockedExchangePointer((PVOID volatile *)&fbuf[vread], NULL);
-        const size_t     tchars = frame->flength * frame->fwidth;
-        
-        if (conbuf == NULL || frame->flength != conbuf_size.Y || frame->fwidth != conbuf_size.X) {
-            free(conbuf);
-            conbuf = malloc(frame->flength * frame->fwidth * sizeof(CHAR_INFO));
-            CHECK(excv, conbuf == NULL, TL_ALLOC_FAILURE, goto epilogue);
-            conbuf_size.X = (SHORT)frame->fwidth;
-            conbuf_size.Y = (SHORT)frame->flength;
-            write_region.Left = (SHORT)frame->x_start;
-
-            // + 1 to make sure the frame doesn't overlap with the stat print.
-            write_region.Top = (SHORT)frame->y_start + 1;
-            write_region.Right = (SHORT)(frame->x_start + frame->fwidth - 1);
-            write_region.Bottom = (SHORT)(frame->y_start + frame->flength - 1);
-        }
-        const double pts = frame->pts;
-        AcquireSRWLockShared(&pl->srw_mclock);
-        const double clock = get_atomic_double(&pl->main_clock);
-        ReleaseSRWLockShared(&pl->srw_mclock);
-        const double drift = clock - pts;
-
-        if (drift > 1.0) {
+        // Behind. Skips ahead to the newest frame that's due, those in between only get decoded.
+        con_frame *next = NULL;
+        if (drift >= 0.0 && peek_conframe(pl->video_ring, &next) && next != NULL &&
+            next->pts <= clock) {
+            add_atomic_size_t(&pl->skipped_frames, 1);
             destroy_conframe(&frame);
-            set_atomic_size_t(&pl->vread_idx, nvread);
             continue;
         }
-        if (drift < -(1 / (double)V_FPS)) {
+        if (drift < -V_PRESENT_SLACK_S) {
+            // Early. Sleeps until the deadline, any state change (seeking, pausing) cuts it short.
             // -drift to turn it positive again.
-            Sleep((DWORD)(-drift * 1000.0));
-        }
-        int lz4_dret = LZ4_decompress_fast(
-            frame->compressed_data, (char *)uncomp_fbuffer, (int)frame->uncompressed_bsize
-        );
-        CHECK(excv, lz4_dret == 0, TL_COMPRESS_ERR, goto epilogue);
-        for (size_t i = 0; i < tchars; ++i) {
-            conbuf[i].Char.UnicodeChar = uncomp_fbuffer[i];
+            wait_for_deadline(pl, VIDEO_EVENT_WAKE_HNDLE, timer, -drift);
+            continue;
         }
-        const DWORD clr_mode = (DWORD)get_atomic_size_t(&pl->color_mode);
-        for (size_t i = 0; i < tchars; ++i) {
 
-            // Background color is implicit black/default from attributes set to 0.
-            conbuf[i].Attributes = 0;
-            conbuf[i].Attributes |= clr_mode;
+        // Reduced rate for slow outputs. Frames passed over were decoded already.
+        const size_t rate_div = out_rate_div[get_atomic_size_t_relaxed(&pl->output_level)];
+        if (frame->pts < shown_pts + frame_intv * (double)rate_div - V_PRESENT_SLACK_S) {
+            add_atomic_size_t(&pl->skipped_frames, 1);
+            destroy_conframe(&frame);
+            continue;
         }
-        CHECK(
-            excv, !WriteConsoleOutputW(stdouth, conbuf, conbuf_size, hm, &write_region),
-            TL_CONSOLE_ERR, goto epilogue
-        );
+        const bool moved = shown_ln != 0 &&
+                           (frame->flength != shown_ln || frame->fwidth != shown_wdth ||
+                            frame->y_start != shown_row || frame->x_start != shown_col);
+
+        // Still scene. A frame identical to what's on screen isn't repainted, one that's only
+        // slightly off waits until its changes add up, or for `V_STILL_REPAINT_S`. The first
+        // frame that moves goes out right away.
+        if (still_run >= V_STILL_RUN_FRAMES && shown_ln != 0 && !moved &&
+            snap.color_mode == shown_clm) {
+            const size_t alike_cells = frame->flength * frame->fwidth / V_STILL_CELL_DIV;
+            if (frame->hash == shown_hash) {
+                unshown_cells = 0;
+            }
+            if (unshown_cells <= alike_cells && frame->pts < shown_pts + V_STILL_REPAINT_S) {
+                add_atomic_size_t(&pl->still_frames, 1);
+                destroy_conframe(&frame);
+                continue;
+            }
+        }
+        const size_t bsize =
+            frame->flength * (VT_CUP_BSIZE + frame->fwidth * BRAILLE_UTF8_BSIZE) + VT_CUP_BSIZE;
+        out_frame *out = NULL;
+        TRY(excv, mailbox_back(pl->mailbox, bsize, &out), goto epilogue);
+        out->length = compose_frame(frame, masks, snap.color_mode, out->bytes, bsize);
+
+        // Removes left-behind artifacts upon resizing.
+        out->clear = moved;
+        out->serial = set_serial;
+        shown_ln = frame->flength;
+        shown_wdth = frame->fwidth;
+        shown_row = frame->y_start;
+        shown_col = frame->x_start;
+        if (mailbox_post(pl->mailbox)) {
+            add_atomic_size_t(&pl->replaced_frames, 1);
+        }
+        shown_pts = frame->pts;
+        shown_hash = frame->hash;
+        shown_clm = snap.color_mode;
+        unshown_cells = 0;
+        set_atomic_size_t(&pl->last_fhash, (size_t)frame->hash);
         destroy_conframe(&frame);
-        set_atomic_size_t(&pl->vread_idx, nvread);
     }
 epilogue:
-    clear_screen(stdouth);
-    free(conbuf);
-    free(uncomp_fbuffer);
+    if (timer) {
+        CloseHandle(timer);
+    }
+    destroy_conframe(&frame);
+    destroy_frame_codec(&codec);
     return excv;
 }
 
-static tl_result clear_screen(HANDLE stdouth) {
+tl_result vwthread_exec(thread_data *data) {
     tl_result excv = TL_SUCCESS;
-    CHECK(excv, stdouth == NULL || stdouth == INVALID_HANDLE_VALUE, TL_INVALID_ARG, return excv);
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    CHECK(excv, !GetConsoleScreenBufferInfo(stdouth, &csbi), TL_OS_ERR, return excv);
-    const DWORD cellc = csbi.dwSize.X * csbi.dwSize.Y;
-    const COORD hm = {.X = 0, .Y = 0};
-    DWORD       coutc = 0;
-    CHECK(
-        excv, !FillConsoleOutputCharacterW(stdouth, L' ', cellc, hm, &coutc), TL_CONSOLE_ERR,
-        return excv
-    );
-    CHECK(
-        excv, !FillConsoleOutputAttribute(stdouth, csbi.wAttributes, cellc, hm, &coutc),
-        TL_CONSOLE_ERR, return excv
-    );
-    CHECK(excv, !SetConsoleCursorPosition(stdouth, hm), TL_CONSOLE_ERR, return excv);
-    return excv;
-}
+    CHECK(excv, data == NULL, TL_NULL_ARG, return excv);
+    player      *pl = data->player;
+    const double frame_intv = (double)pl->media_mtdta->fps_den / pl->media_mtdta->fps_num;
+    double       latency = 0.0;    // EWMA of the time from post to written.
+    double       written_at = 0.0; // `mono_time()` of the last write.
+    output_gov   gov = {.level = OUT_FULL, .write_s = 0.0, .bytes = 0.0, .changed_at = mono_time()};
+    char         status[GBUFFER_BSIZE]; // Latest status line.
+    size_t       status_length = 0;
+    bool         status_pending = false; // Posted, but not written yet.
+    char        *vt = NULL;              // Everything a write pushes.
+    size_t       vt_bsize = 0;
+    DWORD        vt_written = 0;
+    HANDLE       stdouth = GetStdHandle(STD_OUTPUT_HANDLE);
+    CHECK(excv, stdouth == NULL || stdouth == INVALID_HANDLE_VALUE, TL_OS_ERR, return excv);
 
-static tl_result threshold(
-    void     **_ext_data,
-    raw_frame *rf
-) {
-    // No-op. Thresholding is handled by the converter instead (<128 & >=128).
-    return TL_SUCCESS;
-}
+    while (true) {
+        if (get_atomic_bool(&pl->ctrl.shutdown)) {
+            break;
+        }
+        out_frame *out = mailbox_take(pl->mailbox);
+        if (mailbox_take_status(pl->mailbox, status, &status_length)) {
+            status_pending = true;
+        }
+        if (out == NULL && !status_pending) {
+            wait_for_wake(pl, VIDEO_WRITE_EVENT_WAKE_HNDLE, INFINITE);
+            continue;
+        }
 
-static tl_result flyd_stnbrg(
-    void     **_ext_data,
-    raw_frame *rf
-) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-    static const uint8_t kernel[FLOYD_STEINBERG_KERNEL_SIZE] = {
-        (uint8_t)(256 * (float)7 / 16), (uint8_t)(256 * (float)3 / 16),
-        (uint8_t)(256 * (float)3 / 16), (uint8_t)(256 * (float)3 / 16)
-    };
-    static size_t idxs[FLOYD_STEINBERG_KERNEL_SIZE] = {0, 0, 0, 0};
-    static bool   is_valid[FLOYD_STEINBERG_KERNEL_SIZE] = {false, false, false, false};
-    size_t        cidx = 0;
-    uint8_t       value = 0;
-    int16_t       delta = 0;
-    int16_t       diffuse = 0;
-
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            cidx = y * rf->fwidth + x;
-            value = rf->data[cidx] < 128 ? 0 : 255;
-            delta = rf->data[cidx] - value;
-            rf->data[cidx] = value;
-
-            idxs[0] = cidx + 1;
-            idxs[1] = cidx - 1 + rf->fwidth;
-            idxs[2] = cidx + rf->fwidth;
-            idxs[3] = cidx + 1 + rf->fwidth;
-
-            is_valid[0] = (x + 1) < rf->fwidth;
-            is_valid[1] = x > 0 && (y + 1) < rf->flength;
-            is_valid[2] = (y + 1) < rf->flength;
-            is_valid[3] = (x + 1) < rf->fwidth && (y + 1) < rf->flength;
-
-            for (size_t i = 0; i < FLOYD_STEINBERG_KERNEL_SIZE; ++i) {
-                if (!is_valid[i]) {
-                    continue;
-                }
-                diffuse = rf->data[idxs[i]] + ((delta * kernel[i]) >> 8);
-                diffuse = diffuse > 0 ? diffuse : 0;
-                diffuse = diffuse < 255 ? diffuse : 255;
-                rf->data[idxs[i]] = (uint8_t)diffuse;
-            }
+        // Frames carry the status line along. It only goes out on its own once they stop coming.
+        if (out == NULL && mono_time() - written_at < POLLING_RATE_S) {
+            wait_for_wake(pl, VIDEO_WRITE_EVENT_WAKE_HNDLE, POLLING_RATE_MS);
+            continue;
         }
-    }
-    return excv;
-}
 
-static tl_result blue_dth(
-    void     **ext_data,
-    raw_frame *rf
-) {
-    static const WCHAR *btexture_pth = L"assets\\bnoise.raw";
-    static const size_t btexture_length = 8192;
-    static const size_t btexture_width = 8192;
-    static bool         reload = true;
-    static size_t       set_length = 0;
-    static size_t       set_width = 0;
-    static size_t       fcount = 0;
-    static const size_t threshold[DTH_BLUE_MODES] = {V_FPS - 8, V_FPS - 15, V_FPS - 23, 0};
-    tl_result           excv = TL_SUCCESS;
-    WCHAR               exec_path[MAX_PATH];
-    WCHAR               ftexture_pth[MAX_PATH];
-    FILE               *data = NULL;
-    uint8_t            *texture = NULL;
-    CHECK(
-        excv,
-        rf->flength == 0 || rf->fwidth == 0 || rf->flength > btexture_length ||
-            rf->fwidth > btexture_width,
-        TL_INVALID_ARG, goto epilogue
-    );
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, ext_data == NULL, TL_NULL_ARG, return excv);
-    if (set_length != rf->flength || set_width != rf->fwidth) {
-        set_length = rf->flength;
-        set_width = rf->fwidth;
-        reload = true;
-    }
-    if (reload) {
-        DWORD get_exec = GetModuleFileNameW(NULL, exec_path, MAX_PATH);
-        CHECK(excv, get_exec >= MAX_PATH || get_exec == 0, TL_OS_ERR, goto epilogue);
-        HRESULT hr_remove = PathCchRemoveFileSpec(exec_path, MAX_PATH);
-        CHECK(excv, !SUCCEEDED(hr_remove), TL_OS_ERR, goto epilogue);
-        HRESULT hr_combine = PathCchCombine(ftexture_pth, MAX_PATH, exec_path, btexture_pth);
-        CHECK(excv, !SUCCEEDED(hr_combine), TL_OS_ERR, goto epilogue);
-        DWORD fattr = GetFileAttributesW(ftexture_pth);
-        CHECK(excv, fattr == INVALID_FILE_ATTRIBUTES, TL_DEP_NOT_FOUND, goto epilogue);
-
-        free(_InterlockedExchangePointer((volatile PVOID *)ext_data, NULL));
-        texture = malloc(rf->flength * rf->fwidth * sizeof(uint8_t));
-        CHECK(excv, texture == NULL, TL_ALLOC_FAILURE, goto epilogue);
-        errno_t data_open = _wfopen_s(&data, ftexture_pth, L"rb");
-        CHECK(excv, data == NULL || data_open != 0, TL_PIPE_CREATION_FAILURE, goto epilogue);
-        const size_t bskip = (btexture_width - rf->fwidth) * sizeof(uint8_t);
-        for (size_t i = 0; i < set_length; ++i) {
-            size_t fret = fread(texture + (i * rf->fwidth), sizeof(uint8_t), rf->fwidth, data);
-            CHECK(excv, fret != rf->fwidth, TL_PIPE_READ_FAILURE, goto epilogue);
-            if (bskip > 0) {
-                int fret_discard = fseek(data, (long)bskip, SEEK_CUR);
-                CHECK(excv, fret_discard != 0, TL_PIPE_READ_FAILURE, goto epilogue);
-            }
+        // Frames posted before a seek are dropped, the status line gives way to debug prints.
+        const bool show_frame = out != NULL && out->length > 0 &&
+                                out->serial == get_atomic_size_t(&pl->ctrl.serial);
+        const bool show_status = status_length > 0 && !get_atomic_bool(&pl->ctrl.debug_print);
+        const size_t bsize = (show_frame ? out->length : 0) + status_length + VT_WRITE_OVERHEAD;
+        if (vt_bsize < bsize) {
+            free(vt);
+            vt_bsize = 0;
+            vt = malloc(bsize);
+            CHECK(excv, vt == NULL, TL_ALLOC_FAILURE, goto epilogue);
+            vt_bsize = bsize;
         }
-        int exret = fclose(data);
-        data = NULL;
-        CHECK(excv, exret != 0, TL_PIPE_PROC_FAILURE, goto epilogue);
-        _InterlockedExchangePointer((volatile PVOID *)ext_data, (PVOID)texture);
-        reload = false;
-    }
-    const size_t mod_fps = fcount % V_FPS;
-    uint8_t     *frame_data = rf->data;
-    size_t       mode = 0;
-    for (size_t i = 0; i < DTH_BLUE_MODES; ++i) {
-        if (threshold[i] > mod_fps) {
-            mode++;
-            continue;
+
+        // One write, repainted at once by terminals that support synchronized updates, so they
+        // never show a half-drawn frame. The others ignore the markers.
+        size_t length = 0;
+        append_bytes(vt, &length, VT_SYNC_BEGIN, sizeof(VT_SYNC_BEGIN) - 1);
+        if (out != NULL && out->clear) {
+            append_bytes(vt, &length, VT_CLEAR, sizeof(VT_CLEAR) - 1);
         }
-        break;
-    }
-    const size_t total_px = set_length * set_width;
-    const size_t start_idx[DTH_BLUE_MODES] = {
-        0, total_px - 1, rf->fwidth - 1, total_px - rf->fwidth
-    };
-    const size_t access_column[DTH_BLUE_MODES] = {0, 0, 2 * rf->fwidth, -2 * rf->fwidth};
-    const int8_t access_width[DTH_BLUE_MODES] = {1, -1, -1, 1};
-
-    size_t fidx = 0;
-    size_t txt_idx = start_idx[mode];
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            fidx = y * rf->fwidth + x;
-            if (frame_data[fidx] > ((uint8_t *)(*ext_data))[txt_idx]) {
-                frame_data[fidx] = UINT8_MAX;
-            } else {
-                frame_data[fidx] = 0;
-            }
-            txt_idx += access_width[mode];
+        if (show_status) {
+            append_bytes(vt, &length, VT_HOME, sizeof(VT_HOME) - 1);
+            append_bytes(vt, &length, status, status_length);
+            append_bytes(vt, &length, VT_ERASE_LINE, sizeof(VT_ERASE_LINE) - 1);
         }
-        txt_idx += access_column[mode];
-    }
-    fcount++;
-epilogue:
-    if (excv != TL_SUCCESS) {
-        if (data) {
-            fclose(data);
-            data = NULL;
+        if (show_frame) {
+            append_bytes(vt, &length, out->bytes, out->length);
         }
-        free(texture);
+        append_bytes(vt, &length, VT_SYNC_END, sizeof(VT_SYNC_END) - 1);
+
+        // Blocks for as long as the terminal takes to catch up, which is what gets measured.
+        const double write_start = mono_time();
+        CHECK(
+            excv, !WriteFile(stdouth, vt, (DWORD)length, &vt_written, NULL), TL_CONSOLE_ERR,
+            goto epilogue
+        );
+        written_at = mono_time();
+        status_pending = false;
+        if (!show_frame) {
+            continue;
+        }
+        latency += OUT_EWMA_ALPHA * ((written_at - out->posted_at) - latency);
+        govern_output(
+            &gov, written_at - write_start, length, frame_intv,
+            get_atomic_size_t(&pl->ctrl.output_target)
+        );
+        set_atomic_size_t(&pl->output_level, gov.level);
+        set_atomic_double(&pl->output_bps, gov.bytes / (frame_intv * out_rate_div[gov.level]));
+        set_atomic_double(&pl->write_s, gov.write_s);
+        set_atomic_double(&pl->write_latency, latency);
     }
+epilogue:
+    WriteFile(
+        stdouth, VT_RESET VT_CLEAR VT_HOME, sizeof(VT_RESET VT_CLEAR VT_HOME) - 1, &vt_written,
+        NULL
+    );
+    free(vt);
     return excv;
 }
 
-static tl_result halftone(
-    void     **ext_data,
-    raw_frame *rf
+/// @brief Posts a frame that only clears the screen.
+static tl_result post_clear(
+    player      *pl,
+    const size_t serial
 ) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-
-    // We use a spiral pattern dither here.
-    static const uint8_t matrix[HALFTONE_MATRIX_SIZE] = {
-        (uint8_t)(255 * 10 / (double)16), (uint8_t)(255 * 9 / (double)16),
-        (uint8_t)(255 * 8 / (double)16),  (uint8_t)(255 * 7 / (double)16),
-        (uint8_t)(255 * 11 / (double)16), (uint8_t)(255 * 16 / (double)16),
-        (uint8_t)(255 * 15 / (double)16), (uint8_t)(255 * 6 / (double)16),
-        (uint8_t)(255 * 12 / (double)16), (uint8_t)(255 * 13 / (double)16),
-        (uint8_t)(255 * 14 / (double)16), (uint8_t)(255 * 5 / (double)16),
-        (uint8_t)(255 * 1 / (double)16),  (uint8_t)(255 * 2 / (double)16),
-        (uint8_t)(255 * 3 / (double)16),  (uint8_t)(255 * 4 / (double)16)
-    };
-    uint8_t  threshold_idx = 0;
-    size_t   data_idx = 0;
-    uint8_t *data = rf->data;
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            data_idx = y * rf->fwidth + x;
-            threshold_idx = ((y & 3) << 2) | (x & 3);
-            data[data_idx] = matrix[threshold_idx] > data[data_idx] ? 0 : 255;
-        }
-    }
-    return TL_SUCCESS;
-}
-
-/// @brief A modified version of Sierra Lite.
-static tl_result sierra_lite(
-    void     **_ext_data,
-    raw_frame *rf
-) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-
-    // The original kernel discarded 25% of the error, here we use all of it,
-    // split it evenly, and shift the bottom kernel to the bottom left.
-    static const uint8_t kernel[SIERRA_LITE_KERNEL_SIZE] = {128, 128};
-    static size_t        idxs[SIERRA_LITE_KERNEL_SIZE] = {0, 0};
-    static bool          is_valid[SIERRA_LITE_KERNEL_SIZE] = {false, false};
-    size_t               cidx = 0;
-    uint8_t              value;
-    int16_t              delta = 0;
-    int16_t              diffuse = 0;
-
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            cidx = y * rf->fwidth + x;
-            value = rf->data[cidx] < 128 ? 0 : 255;
-            delta = rf->data[cidx] - value;
-            rf->data[cidx] = value;
-
-            idxs[0] = cidx + 1;
-            idxs[1] = cidx - 1 + rf->fwidth;
-            is_valid[0] = (x + 1) < rf->fwidth;
-            is_valid[1] = (x > 0) && (y + 1) < rf->flength;
-
-            for (size_t i = 0; i < SIERRA_LITE_KERNEL_SIZE; ++i) {
-                if (!is_valid[i]) {
-                    continue;
-                }
-                diffuse = rf->data[idxs[i]] + ((delta * kernel[i]) >> 8);
-                diffuse = diffuse > 0 ? diffuse : 0;
-                diffuse = diffuse < 255 ? diffuse : 255;
-                rf->data[idxs[i]] = (uint8_t)diffuse;
-            }
-        }
+    tl_result  excv = TL_SUCCESS;
+    out_frame *out = NULL;
+    TRY(excv, mailbox_back(pl->mailbox, 0, &out), return excv);
+    out->clear = true;
+    out->serial = serial;
+    if (mailbox_post(pl->mailbox)) {
+        add_atomic_size_t(&pl->replaced_frames, 1);
     }
     return excv;
 }
 
-static tl_result bayer_4x4(
-    void     **_ext_data,
-    raw_frame *rf
+/// @brief Writes a frame out as VT sequences. Its color first, then every row at its position.
+/// @return Bytes written.
+static size_t compose_frame(
+    const con_frame *frame,
+    const uint8_t   *masks,
+    const color_mode clm,
+    char            *out,
+    const size_t     bsize
 ) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-
-    // The mathematical bayer matrix was supposed to have 0 at the first entry (0, 0)
-    // but I changed it to have a threshold of 1 for aesthetic purposes allowing for deep blacks.
-    static const uint8_t matrix[BAYER_4X4_MATRIX_SIZE] = {15, 127, 31, 159, 191, 63,  223, 95,
-                                                          47, 175, 15, 143, 239, 111, 207, 79};
-
-    uint8_t  threshold_idx = 0;
-    size_t   data_idx = 0;
-    uint8_t *data = rf->data;
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            data_idx = y * rf->fwidth + x;
-            threshold_idx = ((y & 3) << 2) | (x & 3);
-            data[data_idx] = matrix[threshold_idx] > data[data_idx] ? 0 : 255;
+    // Console attributes are BGR plus an intensity bit, SGR colors are RGB.
+    const int rgb = (clm & 0b0100 ? 1 : 0) | (clm & 0b0010 ? 2 : 0) | (clm & 0b0001 ? 4 : 0);
+    size_t    length = (size_t)snprintf(out, bsize, "\x1b[%dm", (clm & 0b1000 ? 90 : 30) + rgb);
+
+    // Every row goes one down to make sure the frame doesn't overlap with the stat print, so the
+    // last one is left out. VT rows and columns count from 1.
+    for (size_t row = 0; row + 1 < frame->flength; ++row) {
+        length += (size_t)snprintf(
+            out + length, bsize - length, "\x1b[%zu;%zuH", frame->y_start + row + 2,
+            frame->x_start + 1
+        );
+        const uint8_t *row_masks = masks + row * frame->fwidth;
+        for (size_t col = 0; col < frame->fwidth; ++col) {
+            braille_utf8(row_masks[col], out + length);
+            length += BRAILLE_UTF8_BSIZE;
         }
     }
-    return TL_SUCCESS;
-}
-
-static tl_result bayer_8x8(
-    void     **_ext_data,
-    raw_frame *rf
-) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-
-    // The mathematical bayer matrix was supposed to have 0
-    // but I changed it to have a threshold of 1 for aesthetic purposes allowing for deep blacks.
-    static const uint8_t matrix[BAYER_8X8_MATRIX_SIZE] = {
-        3,  127, 31, 159, 7,  135, 39, 167, 191, 63,  223, 95,  199, 71,  231, 103,
-        47, 175, 15, 143, 55, 183, 23, 151, 239, 111, 207, 79,  247, 119, 215, 87,
-        11, 139, 43, 171, 3,  131, 35, 163, 203, 75,  235, 107, 195, 67,  227, 99,
-        59, 187, 27, 155, 51, 179, 19, 147, 251, 123, 219, 91,  243, 115, 211, 83
-    };
-
-    uint8_t  threshold_idx = 0;
-    size_t   data_idx = 0;
-    uint8_t *data = rf->data;
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            data_idx = y * rf->fwidth + x;
-            threshold_idx = ((y & 7) << 3) | (x & 7);
-            data[data_idx] = matrix[threshold_idx] > data[data_idx] ? 0 : 255;
-        }
-    }
-    return TL_SUCCESS;
+    append_bytes(out, &length, VT_RESET, sizeof(VT_RESET) - 1);
+    return length;
 }
 
-static tl_result bayer_16x16(
-    void     **_ext_data,
-    raw_frame *rf
+static void append_bytes(
+    char        *dst,
+    size_t      *length,
+    const void  *src,
+    const size_t bsize
 ) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, rf == NULL, TL_NULL_ARG, return excv);
-
-    // The mathematical bayer matrix was supposed to have 0
-    // but I changed it to have a threshold of 1 for aesthetic purposes allowing for deep blacks.
-    static const uint8_t matrix[BAYER_16X16_MATRIX_SIZE] = {
-        0,   128, 32,  160, 8,   136, 40,  168, 2,   130, 34,  162, 10,  138, 42,  170, 192, 64,
-        224, 96,  200, 72,  232, 104, 194, 66,  226, 98,  202, 74,  234, 106, 48,  176, 16,  144,
-        56,  184, 24,  152, 50,  178, 18,  146, 58,  186, 26,  154, 240, 112, 208, 80,  248, 120,
-        216, 88,  242, 114, 210, 82,  250, 122, 218, 90,  12,  140, 44,  172, 4,   132, 36,  164,
-        14,  142, 46,  174, 6,   134, 38,  166, 204, 76,  236, 108, 196, 68,  228, 100, 206, 78,
-        238, 110, 198, 70,  230, 102, 60,  188, 28,  156, 52,  180, 20,  148, 62,  190, 30,  158,
-        54,  182, 22,  150, 252, 124, 220, 92,  244, 116, 212, 84,  254, 126, 222, 94,  246, 118,
-        214, 86,  3,   131, 35,  163, 11,  139, 43,  171, 1,   129, 33,  161, 9,   137, 41,  169,
-        195, 67,  227, 99,  203, 75,  235, 107, 197, 69,  229, 101, 205, 77,  237, 109, 51,  179,
-        19,  147, 59,  187, 27,  155, 49,  177, 17,  145, 57,  185, 25,  153, 243, 115, 211, 83,
-        251, 123, 219, 91,  241, 113, 209, 81,  249, 121, 217, 89,  15,  143, 47,  175, 7,   135,
-        39,  167, 13,  141, 45,  173, 5,   133, 37,  165, 207, 79,  239, 111, 199, 71,  231, 103,
-        209, 81,  241, 113, 201, 73,  233, 105, 63,  191, 31,  159, 55,  183, 23,  151, 61,  189,
-        29,  157, 53,  181, 21,  149, 255, 127, 223, 95,  247, 119, 215, 87,  253, 125, 221, 93,
-        245, 117, 213, 85
-    };
-    uint8_t  threshold_idx = 0;
-    size_t   data_idx = 0;
-    uint8_t *data = rf->data;
-    for (size_t y = 0; y < rf->flength; ++y) {
-        for (size_t x = 0; x < rf->fwidth; ++x) {
-            data_idx = y * rf->fwidth + x;
-            threshold_idx = ((y & 15) << 4) | (x & 15);
-            data[data_idx] = matrix[threshold_idx] >= data[data_idx] ? 0 : 255;
-        }
-    }
-    return TL_SUCCESS;
-}
-
-static tl_result apply_dither(
-    void            **ext_data,
-    const dither_mode dmode,
-    raw_frame        *rframe
-) {
-    tl_result excv = TL_SUCCESS;
-    CHECK(excv, dmode < 0 || dmode > DTH_MODES, TL_INVALID_ARG, return excv);
-    CHECK(excv, rframe == NULL, TL_NULL_ARG, return excv);
-    CHECK(excv, ext_data == NULL, TL_NULL_ARG, return excv);
-    static bool setup = true;
-    static tl_result (*(dither_funcs[DTH_MODES]))(void **ext_data, raw_frame *);
-    if (setup) {
-        dither_funcs[DTH_THRESHOLDING] = threshold;
-        dither_funcs[DTH_FLOYD_STEINBERG] = flyd_stnbrg;
-        dither_funcs[DTH_BAYER_4X4] = bayer_4x4;
-        dither_funcs[DTH_BAYER_8X8] = bayer_8x8;
-        dither_funcs[DTH_BAYER_16X16] = bayer_16x16;
-        dither_funcs[DTH_BLUE] = blue_dth;
-        dither_funcs[DTH_HALFTONE] = halftone;
-        dither_funcs[DTH_SIERRA_LITE] = sierra_lite;
-        setup = false;
-    }
-    TRY(excv, dither_funcs[dmode](ext_data, rframe), return excv);
-    return excv;
-}
+    memcpy(dst + *length, src, bsize);
+    *length += bsize;
+}
\ No newline at end of file
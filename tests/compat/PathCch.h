@@ -0,0 +1,14 @@
+#pragma once
+
+#include <Windows.h>
+
+HRESULT PathCchRemoveFileSpec(
+    WCHAR *path,
+    size_t size
+);
+HRESULT PathCchCombine(
+    WCHAR       *out,
+    size_t       size,
+    const WCHAR *dir,
+    const WCHAR *file
+);
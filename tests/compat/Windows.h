@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+Just enough of Win32 for the dithering, scaling and pool sources to build and run on POSIX, so
+that their output can be tested off Windows. Only built into the tests, see win32.c.
+*/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h> // The real one brings it in, and sources rely on it.
+#include <wchar.h>
+
+typedef int       BOOL;
+typedef uint32_t  DWORD;
+typedef int32_t   LONG;
+typedef int32_t   HRESULT;
+typedef unsigned  UINT;
+typedef uintptr_t DWORD_PTR;
+typedef wchar_t   WCHAR;
+typedef void     *HANDLE;
+typedef int       errno_t;
+
+typedef struct SRWLOCK {
+    pthread_mutex_t mutex; // Never destroyed, like the real thing.
+} SRWLOCK;
+
+typedef struct SYSTEM_INFO {
+    DWORD dwNumberOfProcessors;
+} SYSTEM_INFO;
+
+#define TRUE 1
+#define FALSE 0
+#define INFINITE 0xFFFFFFFF
+#define WAIT_OBJECT_0 0x00000000
+#define WAIT_TIMEOUT 0x00000102
+#define MAX_PATH 260
+#define MAXLONG 0x7FFFFFFF
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define _stdcall
+#define __stdcall
+
+void InitializeSRWLock(SRWLOCK *lock);
+void AcquireSRWLockExclusive(SRWLOCK *lock);
+void ReleaseSRWLockExclusive(SRWLOCK *lock);
+
+HANDLE CreateSemaphoreW(
+    void        *attributes,
+    LONG         initial,
+    LONG         maximum,
+    const WCHAR *name
+);
+BOOL ReleaseSemaphore(
+    HANDLE sem,
+    LONG   count,
+    LONG  *previous
+);
+HANDLE CreateEventW(
+    void        *attributes,
+    BOOL         manual_reset,
+    BOOL         initial,
+    const WCHAR *name
+);
+BOOL SetEvent(HANDLE event);
+DWORD WaitForSingleObject(
+    HANDLE handle,
+    DWORD  timeout_ms
+);
+BOOL CloseHandle(HANDLE handle);
+
+void      GetSystemInfo(SYSTEM_INFO *info);
+DWORD_PTR SetThreadAffinityMask(
+    HANDLE    thread,
+    DWORD_PTR mask
+);
+void YieldProcessor(void);
+
+DWORD GetModuleFileNameW(
+    void  *module,
+    WCHAR *out,
+    DWORD  size
+);
+BOOL CreateDirectoryW(
+    const WCHAR *path,
+    void        *attributes
+);
+errno_t _wfopen_s(
+    FILE       **out,
+    const WCHAR *path,
+    const WCHAR *mode
+);
+int _wremove(const WCHAR *path);
+
+void *_aligned_malloc(
+    size_t bsize,
+    size_t alignment
+);
+void _aligned_free(void *block);
@@ -0,0 +1,3 @@
+#pragma once
+
+// Nothing the tested sources use.
@@ -0,0 +1,3 @@
+#pragma once
+
+// Only the renderer compresses, and it isn't built into the tests.
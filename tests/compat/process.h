@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+uintptr_t _beginthreadex(
+    void     *security,
+    unsigned  stack_bsize,
+    unsigned (*start)(void *),
+    void     *arg,
+    unsigned  flags,
+    unsigned *thread_id
+);
@@ -0,0 +1,213 @@
+#include <Windows.h>
+#include <PathCch.h>
+#include <emmintrin.h>
+#include <process.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+POSIX stand-ins for the Win32 calls in Windows.h. Handles are either a counting semaphore or a
+thread. Events are only ever auto-reset, which makes them semaphores that count up to 1. Files
+are never opened, so the blue noise tile gets generated instead of cached.
+*/
+
+typedef enum handle_kind { HK_SEMAPHORE, HK_THREAD } handle_kind;
+
+typedef struct win_handle {
+    handle_kind     kind;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    LONG            count; // Semaphore.
+    LONG            maximum;
+    pthread_t       thread;
+    unsigned (*start)(void *);
+    void *arg;
+} win_handle;
+
+void InitializeSRWLock(SRWLOCK *lock) { pthread_mutex_init(&lock->mutex, NULL); }
+
+void AcquireSRWLockExclusive(SRWLOCK *lock) { pthread_mutex_lock(&lock->mutex); }
+
+void ReleaseSRWLockExclusive(SRWLOCK *lock) { pthread_mutex_unlock(&lock->mutex); }
+
+HANDLE CreateSemaphoreW(
+    void        *attributes,
+    LONG         initial,
+    LONG         maximum,
+    const WCHAR *name
+) {
+    win_handle *h = calloc(1, sizeof(win_handle));
+    if (h == NULL) {
+        return NULL;
+    }
+    h->kind = HK_SEMAPHORE;
+    h->count = initial;
+    h->maximum = maximum;
+    pthread_mutex_init(&h->mutex, NULL);
+    pthread_cond_init(&h->cond, NULL);
+    return h;
+}
+
+BOOL ReleaseSemaphore(
+    HANDLE sem,
+    LONG   count,
+    LONG  *previous
+) {
+    win_handle *h = (win_handle *)sem;
+    pthread_mutex_lock(&h->mutex);
+    if (previous != NULL) {
+        *previous = h->count;
+    }
+    h->count = h->maximum - h->count < count ? h->maximum : h->count + count;
+    pthread_cond_broadcast(&h->cond);
+    pthread_mutex_unlock(&h->mutex);
+    return TRUE;
+}
+
+HANDLE CreateEventW(
+    void        *attributes,
+    BOOL         manual_reset,
+    BOOL         initial,
+    const WCHAR *name
+) {
+    return manual_reset ? NULL : CreateSemaphoreW(attributes, initial ? 1 : 0, 1, name);
+}
+
+BOOL SetEvent(HANDLE event) { return ReleaseSemaphore(event, 1, NULL); }
+
+DWORD WaitForSingleObject(
+    HANDLE handle,
+    DWORD  timeout_ms
+) {
+    win_handle *h = (win_handle *)handle;
+    if (h->kind == HK_THREAD) {
+        pthread_join(h->thread, NULL);
+        return WAIT_OBJECT_0;
+    }
+    pthread_mutex_lock(&h->mutex);
+    if (h->count == 0 && timeout_ms == 0) {
+        pthread_mutex_unlock(&h->mutex);
+        return WAIT_TIMEOUT;
+    }
+    while (h->count == 0) {
+        pthread_cond_wait(&h->cond, &h->mutex);
+    }
+    h->count--;
+    pthread_mutex_unlock(&h->mutex);
+    return WAIT_OBJECT_0;
+}
+
+BOOL CloseHandle(HANDLE handle) {
+    win_handle *h = (win_handle *)handle;
+    if (h->kind == HK_SEMAPHORE) {
+        pthread_cond_destroy(&h->cond);
+        pthread_mutex_destroy(&h->mutex);
+    }
+    free(h);
+    return TRUE;
+}
+
+static void *thread_main(void *arg) {
+    win_handle *h = (win_handle *)arg;
+    h->start(h->arg);
+    return NULL;
+}
+
+uintptr_t _beginthreadex(
+    void     *security,
+    unsigned  stack_bsize,
+    unsigned (*start)(void *),
+    void     *arg,
+    unsigned  flags,
+    unsigned *thread_id
+) {
+    win_handle *h = calloc(1, sizeof(win_handle));
+    if (h == NULL) {
+        return 0;
+    }
+    h->kind = HK_THREAD;
+    h->start = start;
+    h->arg = arg;
+    if (pthread_create(&h->thread, NULL, thread_main, h) != 0) {
+        free(h);
+        return 0;
+    }
+    return (uintptr_t)h;
+}
+
+void GetSystemInfo(SYSTEM_INFO *info) {
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    info->dwNumberOfProcessors = count > 0 ? (DWORD)count : 1;
+}
+
+DWORD_PTR SetThreadAffinityMask(
+    HANDLE    thread,
+    DWORD_PTR mask
+) {
+    return 1;
+}
+
+void YieldProcessor(void) { _mm_pause(); }
+
+DWORD GetModuleFileNameW(
+    void  *module,
+    WCHAR *out,
+    DWORD  size
+) {
+    const int written = swprintf(out, size, L"termiplay.exe");
+    return written < 0 ? 0 : (DWORD)written;
+}
+
+HRESULT PathCchRemoveFileSpec(
+    WCHAR *path,
+    size_t size
+) {
+    WCHAR *sep = wcsrchr(path, L'\\');
+    if (sep == NULL) {
+        path[0] = L'\0';
+    } else {
+        *sep = L'\0';
+    }
+    return S_OK;
+}
+
+HRESULT PathCchCombine(
+    WCHAR       *out,
+    size_t       size,
+    const WCHAR *dir,
+    const WCHAR *file
+) {
+    const int written = dir[0] == L'\0' ? swprintf(out, size, L"%ls", file)
+                                        : swprintf(out, size, L"%ls\\%ls", dir, file);
+    return written < 0 ? E_FAIL : S_OK;
+}
+
+BOOL CreateDirectoryW(
+    const WCHAR *path,
+    void        *attributes
+) {
+    return FALSE;
+}
+
+errno_t _wfopen_s(
+    FILE       **out,
+    const WCHAR *path,
+    const WCHAR *mode
+) {
+    *out = NULL;
+    return ENOENT;
+}
+
+int _wremove(const WCHAR *path) { return -1; }
+
+void *_aligned_malloc(
+    size_t bsize,
+    size_t alignment
+) {
+    void *block = NULL;
+    return posix_memalign(&block, alignment, bsize) == 0 ? block : NULL;
+}
+
+void _aligned_free(void *block) { free(block); }
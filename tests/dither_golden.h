@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "tl_types.h"
+
+/*
+Braille grid hashes of the test frames in dither_test.c, by frame then dithering mode. They start
+out as the baseline's output, the kernels as they were in video.c. Every change since is on
+purpose, and noted below with the modes it touched. Tables come from `dither_test --print`.
+
+Changes:
+- Frames are scaled in process rather than by ffmpeg. `golden_scaled` holds the scaler's output,
+  as first written.
+- Floyd-Steinberg, Sierra Lite: one serpentine engine for every kernel, error no longer clamped.
+- Atkinson, Stucki, Jarvis-Judice-Ninke, Burkes: added.
+- Dot diffusion, block error diffusion: added.
+- Pattern matching: added.
+*/
+
+static const uint64_t golden_hashes[][DTH_MODES] = {
+    // gradient
+    {
+        [DTH_BAYER_16X16] = 0xd9aeec732f23f6caULL,
+        [DTH_FLOYD_STEINBERG] = 0x6ecb98c9bf21a33fULL,
+        [DTH_HALFTONE] = 0xbcd45abd6a3cd36dULL,
+        [DTH_BAYER_8X8] = 0xdcbd37ef6a650211ULL,
+        [DTH_BAYER_4X4] = 0x6cf47f7619c43315ULL,
+        [DTH_SIERRA_LITE] = 0xde282d90a0339895ULL,
+        [DTH_ATKINSON] = 0xf3ce960b18e3c3b3ULL,
+        [DTH_STUCKI] = 0x296c490db7494e05ULL,
+        [DTH_JJN] = 0xe2804ba84e8a600bULL,
+        [DTH_BURKES] = 0x78a5f0bc0c4ff1b8ULL,
+        [DTH_DOT_DIFFUSION] = 0x4e5975f44bca8fa3ULL,
+        [DTH_BLOCK_DIFFUSION] = 0x48a6b835c8bd0a2aULL,
+        [DTH_PATTERN] = 0x5ef99881aa72cfd7ULL,
+        [DTH_THRESHOLDING] = 0xb9474618b39805cbULL,
+    },
+    // rings
+    {
+        [DTH_BAYER_16X16] = 0x63b6d0981d489988ULL,
+        [DTH_FLOYD_STEINBERG] = 0xe5703260a13e5a2dULL,
+        [DTH_HALFTONE] = 0xf18236a7c47d7d26ULL,
+        [DTH_BAYER_8X8] = 0x725bc366f3a9c490ULL,
+        [DTH_BAYER_4X4] = 0xf9b635715380b65bULL,
+        [DTH_SIERRA_LITE] = 0xedc87b06b0ea54dcULL,
+        [DTH_ATKINSON] = 0xcd611e2e6ff3f0ebULL,
+        [DTH_STUCKI] = 0x970e04a8020a9bb2ULL,
+        [DTH_JJN] = 0x886b6a3dfa40bdfeULL,
+        [DTH_BURKES] = 0xe6eb8bebf2d1a9e7ULL,
+        [DTH_DOT_DIFFUSION] = 0x0f58bfd262941db2ULL,
+        [DTH_BLOCK_DIFFUSION] = 0xacaf3f60a3d1dc1cULL,
+        [DTH_PATTERN] = 0x0927ffbb0edec5b2ULL,
+        [DTH_THRESHOLDING] = 0xd23da43e0f776f4dULL,
+    },
+    // strokes
+    {
+        [DTH_BAYER_16X16] = 0xe5b99557e34963a7ULL,
+        [DTH_FLOYD_STEINBERG] = 0x2d2045b4eafd4ae5ULL,
+        [DTH_HALFTONE] = 0x105792e00380cb15ULL,
+        [DTH_BAYER_8X8] = 0xb7a7c7bc9da34605ULL,
+        [DTH_BAYER_4X4] = 0x0f1278f0dbeb6385ULL,
+        [DTH_SIERRA_LITE] = 0x9c2348634701ef4dULL,
+        [DTH_ATKINSON] = 0x9c8dead9991a7ff3ULL,
+        [DTH_STUCKI] = 0xecb0606d073dbe41ULL,
+        [DTH_JJN] = 0x2268a5808eca922bULL,
+        [DTH_BURKES] = 0x1285bc571ff354c9ULL,
+        [DTH_DOT_DIFFUSION] = 0x1db4024dc5453df9ULL,
+        [DTH_BLOCK_DIFFUSION] = 0xf94dae5de39dc06fULL,
+        [DTH_PATTERN] = 0x3efe487fdcf0ffdbULL,
+        [DTH_THRESHOLDING] = 0xc2b52b12e18e5bcbULL,
+    },
+    // noise
+    {
+        [DTH_BAYER_16X16] = 0x326ea1c3a9a65f6bULL,
+        [DTH_FLOYD_STEINBERG] = 0xf44aba1c59a6627bULL,
+        [DTH_HALFTONE] = 0x481efdfb1a8990d0ULL,
+        [DTH_BAYER_8X8] = 0x366bc87640cacf85ULL,
+        [DTH_BAYER_4X4] = 0xb9120afaacb21358ULL,
+        [DTH_SIERRA_LITE] = 0x5e0dcae8328fbe99ULL,
+        [DTH_ATKINSON] = 0x6f368126aa9cdadbULL,
+        [DTH_STUCKI] = 0xfcaacda3f6adc537ULL,
+        [DTH_JJN] = 0x93e80ce82006875dULL,
+        [DTH_BURKES] = 0x7503bda7a5edb50aULL,
+        [DTH_DOT_DIFFUSION] = 0x67f3286955599097ULL,
+        [DTH_BLOCK_DIFFUSION] = 0xf265540367aea1c0ULL,
+        [DTH_PATTERN] = 0x9017a78342940445ULL,
+        [DTH_THRESHOLDING] = 0xf910b5db4d548634ULL,
+    },
+};
+
+static const uint64_t golden_scaled[] = {
+    0x28d0b03984526ae1ULL, // gradient
+    0xb7cf0247326f13feULL, // rings
+    0x26a700feb768fc65ULL, // strokes
+    0x79e4527dc0a42007ULL, // noise
+};
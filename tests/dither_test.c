@@ -0,0 +1,581 @@
+#include "dither_golden.h"
+#include "tl_dither.h"
+#include "tl_errors.h"
+#include "tl_pch.h"
+#include "tl_pool.h"
+#include "tl_scale.h"
+#include "tl_types.h"
+#include "tl_utils.h"
+
+/*
+Golden output tests for the scaling, dithering and braille packing stages.
+
+Fixed frames get dithered in every mode and packed, and the braille grids hashed. Exact modes have
+to hash to their golden value in dither_golden.h, bit for bit. So do the frames scaled down to
+them from larger sources, which are checked on their own. Error diffusion kernels also have to
+match a plain, row-major diffuser working from the same `DIFFUSION_LIST` weights. Blue noise
+depends on a tile made with floating point, which can round differently between C runtimes, so
+it's held to a tolerance instead: how far dot density strays from the source's tone, over blocks
+of cells.
+
+On top of that, in every mode:
+- Frames rendered from within a pool task, where modes that can split them among workers do,
+  come out the same as rendered on their own.
+- Modes that pass `dither_reusable()` come out the same dithered a block of cells at a time.
+- Stable dots hold: dithering a frame against its own dots changes nothing, and noise flips no
+  more dots than without them. Strictly fewer, in modes that threshold.
+
+Usage: dither_test [--print]
+--print writes a new golden table to stdout, for when output changes on purpose. The change goes
+into dither_golden.h with the table.
+*/
+
+#define TEST_WORKERS 4      // Pool size, fixed so that runs don't depend on the machine.
+#define TEST_NOISE 8        // Largest luminance change noisy frames make, either way.
+#define TONE_BLOCK_CELL 4   // Tone is compared over blocks of this many cells square.
+#define BLUE_TONE_TOL 8.0   // Mean tone error blue noise is allowed, in luminance.
+
+/// @brief Fixed frame.
+typedef struct test_frame {
+    const char *name;
+    size_t      wdth; // Cell counts that aren't multiples of blocks, on purpose.
+    size_t      ln;
+    size_t      src_wdth; // Source the frame's scaled down from, for the scaler.
+    size_t      src_ln;
+    uint8_t (*px)(size_t x, size_t y);
+} test_frame;
+
+/// @brief Frame being rendered, with everything it renders into.
+typedef struct test_render {
+    dither_ctx   *ctx;
+    raw_frame    *frame; // Tiled.
+    uint8_t      *luma;  // `frame` before dithering.
+    uint8_t      *masks;
+    dither_mode   dmode;
+    tl_result     excv;
+    pool_task     task;
+    atomic_bool_t done;
+} test_render;
+
+/// @brief Error diffusion kernel, for the reference diffuser.
+typedef struct ref_kernel {
+    int    div;
+    int8_t weights[DIFFUSION_TAPS];
+} ref_kernel;
+
+static size_t checks = 0;
+static size_t failures = 0;
+static bool   printing = false; // Writing new golden hashes rather than checking them.
+
+static uint32_t px_hash(
+    const size_t x,
+    const size_t y
+) {
+    uint32_t h = (uint32_t)(x * 73856093u) ^ (uint32_t)(y * 19349663u);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+static uint8_t gradient_px(
+    size_t x,
+    size_t y
+) {
+    const size_t v = x * 4 / 3 + y / 4;
+    return (uint8_t)(v > UINT8_MAX ? UINT8_MAX : v);
+}
+
+static uint8_t rings_px(
+    size_t x,
+    size_t y
+) {
+    const ptrdiff_t dx = (ptrdiff_t)x - 80;
+    const ptrdiff_t dy = (ptrdiff_t)y - 60;
+    return (uint8_t)((dx * dx + dy * dy) / 24);
+}
+
+/// Faint to bright strokes on black, like text and line art.
+static uint8_t strokes_px(
+    size_t x,
+    size_t y
+) {
+    if (x == 2 * y || x == 2 * y + 1) {
+        return UINT8_MAX;
+    }
+    if (y % 12 == 5) {
+        return 200;
+    }
+    return x % 16 == 3 ? (uint8_t)(40 + x / 16 * 16) : 0;
+}
+
+static uint8_t noise_px(
+    size_t x,
+    size_t y
+) {
+    return (uint8_t)(px_hash(x, y) >> 24);
+}
+
+static const test_frame frames[] = {
+    {"gradient", 120, 64, 192, 108, gradient_px},
+    {"rings", 96, 68, 160, 120, rings_px},
+    {"strokes", 200, 80, 200, 80, strokes_px},
+    {"noise", 128, 96, 256, 192, noise_px},
+};
+
+#define TEST_FRAMES (sizeof(frames) / sizeof(frames[0]))
+
+#define NAME(mode) [mode] = #mode,
+static const char *const mode_names[DTH_MODES] = {
+    NAME(DTH_BAYER_16X16)
+    NAME(DTH_HALFTONE)
+    NAME(DTH_BLUE)
+    NAME(DTH_BAYER_8X8)
+    NAME(DTH_BAYER_4X4)
+    NAME(DTH_DOT_DIFFUSION)
+    NAME(DTH_BLOCK_DIFFUSION)
+    NAME(DTH_PATTERN)
+    NAME(DTH_THRESHOLDING)
+#define X(mode, fn, str, div, ...) NAME(mode)
+    DIFFUSION_LIST
+#undef X
+};
+#undef NAME
+
+#define X(mode, fn, str, div, ...) [mode] = {div, {__VA_ARGS__}},
+static const ref_kernel kernels[DTH_MODES] = {DIFFUSION_LIST};
+#undef X
+
+/// @brief Whether a mode has to match its golden hash bit for bit.
+static bool mode_exact(const dither_mode dmode) { return dmode != DTH_BLUE; }
+
+/// @brief Whether a mode holds dots with hysteresis, rather than ignoring `prev_masks`.
+static bool mode_holds(const dither_mode dmode) {
+    return dmode != DTH_DOT_DIFFUSION && dmode != DTH_PATTERN;
+}
+
+static void check(
+    const bool        ok,
+    const test_frame *tf,
+    const dither_mode dmode,
+    const char       *what
+) {
+    checks++;
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "FAIL %s %s: %s\n", tf->name, mode_names[dmode], what);
+    }
+}
+
+/// @brief 64-bit FNV-1a hash of a tiled frame's pixels, in row-major order so that it doesn't
+/// depend on the layout.
+static uint64_t hash_pixels(const raw_frame *rframe) {
+    const size_t cell_wdth = rframe->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    uint64_t     hash = 0xcbf29ce484222325ULL;
+    for (size_t y = 0; y < rframe->flength; ++y) {
+        for (size_t x = 0; x < rframe->fwidth; ++x) {
+            hash ^= rframe->data[tiled_px_idx(cell_wdth, x, y)];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+static size_t cell_count(const test_frame *tf) {
+    return (tf->wdth / BRAILLE_CHAR_DOT_WDTH) * (tf->ln / BRAILLE_CHAR_DOT_LN);
+}
+
+/// @brief Fills a render's frame and luminance, optionally with noise on top.
+static void fill_frame(
+    const test_frame *tf,
+    const bool        noisy,
+    test_render      *tr
+) {
+    const size_t cell_wdth = tf->wdth / BRAILLE_CHAR_DOT_WDTH;
+    for (size_t y = 0; y < tf->ln; ++y) {
+        for (size_t x = 0; x < tf->wdth; ++x) {
+            int v = tf->px(x, y);
+            if (noisy) {
+                v += (int)(px_hash(y, x) % (2 * TEST_NOISE + 1)) - TEST_NOISE;
+            }
+            tr->luma[tiled_px_idx(cell_wdth, x, y)] =
+                (uint8_t)(v < 0 ? 0 : v > UINT8_MAX ? UINT8_MAX : v);
+        }
+    }
+}
+
+static tl_result render(test_render *tr) {
+    tl_result excv = TL_SUCCESS;
+    memcpy(tr->frame->data, tr->luma, tr->frame->fwidth * tr->frame->flength);
+    TRY(excv, apply_dither(tr->ctx, tr->dmode, tr->frame), return excv);
+    pack_braille(tr->frame, tr->masks);
+    return excv;
+}
+
+/// @brief Renders on a pool worker. (`pool_task_fn`)
+static void render_task(
+    pool_task   *task,
+    const size_t worker
+) {
+    test_render *tr = (test_render *)task->arg;
+    tr->excv = render(tr);
+    set_atomic_bool(&tr->done, true);
+}
+
+/// @brief Renders a block of cells at a time, the way the renderer does with a reference.
+static tl_result render_blocks(test_render *tr) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t cell_wdth = tr->frame->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    const size_t cell_ln = tr->frame->flength / BRAILLE_CHAR_DOT_LN;
+    memcpy(tr->frame->data, tr->luma, tr->frame->fwidth * tr->frame->flength);
+    cell_rect block = {.col = 0, .row = 0, .wdth = 0, .ln = 0};
+    for (block.row = 0; block.row < cell_ln; block.row += CHG_BLOCK_CELL_LN) {
+        const size_t rows_left = cell_ln - block.row;
+        block.ln = rows_left < CHG_BLOCK_CELL_LN ? rows_left : CHG_BLOCK_CELL_LN;
+        for (block.col = 0; block.col < cell_wdth; block.col += CHG_BLOCK_CELL_WDTH) {
+            const size_t cols_left = cell_wdth - block.col;
+            block.wdth = cols_left < CHG_BLOCK_CELL_WDTH ? cols_left : CHG_BLOCK_CELL_WDTH;
+            TRY(excv, apply_dither_rect(tr->ctx, tr->dmode, tr->frame, &block), return excv);
+            pack_braille_rect(tr->frame, &block, tr->masks);
+        }
+    }
+    return excv;
+}
+
+static size_t dot_count(
+    const uint8_t *masks,
+    const size_t   count
+) {
+    size_t dots = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (uint8_t m = masks[i]; m != 0; m &= (uint8_t)(m - 1)) {
+            dots++;
+        }
+    }
+    return dots;
+}
+
+static size_t flipped_dots(
+    const uint8_t *a,
+    const uint8_t *b,
+    const size_t   count
+) {
+    size_t dots = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t diff = a[i] ^ b[i];
+        dots += dot_count(&diff, 1);
+    }
+    return dots;
+}
+
+/// @brief Mean difference between dot density and source tone, over blocks of cells.
+static double tone_error(const test_render *tr) {
+    const size_t cell_wdth = tr->frame->fwidth / BRAILLE_CHAR_DOT_WDTH;
+    const size_t cell_ln = tr->frame->flength / BRAILLE_CHAR_DOT_LN;
+    double       error = 0.0;
+    size_t       blocks = 0;
+    for (size_t by = 0; by + TONE_BLOCK_CELL <= cell_ln; by += TONE_BLOCK_CELL) {
+        for (size_t bx = 0; bx + TONE_BLOCK_CELL <= cell_wdth; bx += TONE_BLOCK_CELL) {
+            double luma = 0.0;
+            size_t dots = 0;
+            for (size_t cy = by; cy < by + TONE_BLOCK_CELL; ++cy) {
+                for (size_t cx = bx; cx < bx + TONE_BLOCK_CELL; ++cx) {
+                    const size_t cell = cy * cell_wdth + cx;
+                    dots += dot_count(tr->masks + cell, 1);
+                    for (size_t k = 0; k < BRAILLE_DOTS_PER_CHAR; ++k) {
+                        luma += tr->luma[cell * BRAILLE_DOTS_PER_CHAR + k];
+                    }
+                }
+            }
+            const double px = TONE_BLOCK_CELL * TONE_BLOCK_CELL * BRAILLE_DOTS_PER_CHAR;
+            error += fabs((double)dots * UINT8_MAX / px - luma / px);
+            blocks++;
+        }
+    }
+    return blocks == 0 ? 0.0 : error / blocks;
+}
+
+/// @brief Error diffusion the plain way: row-major, serpentine, error past the edges dropped.
+/// @param tr Render holding the luminance to diffuse. Its frame gets the result.
+/// @param kernel Kernel to diffuse with.
+/// @param masks Output dot masks.
+/// @return Return code.
+static tl_result ref_diffuse(
+    test_render      *tr,
+    const ref_kernel *kernel,
+    uint8_t          *masks
+) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t wdth = tr->frame->fwidth;
+    const size_t ln = tr->frame->flength;
+    const size_t cell_wdth = wdth / BRAILLE_CHAR_DOT_WDTH;
+    int         *err = calloc(wdth * ln, sizeof(int)); // In units of 1/`div`.
+    CHECK(excv, err == NULL, TL_ALLOC_FAILURE, return excv);
+    for (size_t y = 0; y < ln; ++y) {
+        const ptrdiff_t step = y & 1 ? -1 : 1;
+        for (size_t i = 0; i < wdth; ++i) {
+            const size_t x = step > 0 ? i : wdth - 1 - i;
+            const size_t idx = tiled_px_idx(cell_wdth, x, y);
+            const int    value = tr->luma[idx] + err[y * wdth + x] / kernel->div;
+            const int    out = value < 128 ? 0 : UINT8_MAX;
+            tr->frame->data[idx] = (uint8_t)out;
+            for (size_t r = 0; r < DIFFUSION_ROWS && y + r < ln; ++r) {
+                for (size_t c = 0; c < DIFFUSION_COLS; ++c) {
+                    const ptrdiff_t nx = (ptrdiff_t)x + ((ptrdiff_t)c - DIFFUSION_REACH) * step;
+                    if (nx >= 0 && nx < (ptrdiff_t)wdth) {
+                        err[(y + r) * wdth + (size_t)nx] +=
+                            kernel->weights[r * DIFFUSION_COLS + c] * (value - out);
+                    }
+                }
+            }
+        }
+    }
+    pack_braille(tr->frame, masks);
+    free(err);
+    return excv;
+}
+
+/// @brief Scales a frame down from its source, against the golden hash.
+/// @param tf Frame.
+/// @param hash_out Out-parameter to hold the scaled frame's hash.
+/// @return Return code.
+static tl_result test_scale(
+    const test_frame *tf,
+    uint64_t         *hash_out
+) {
+    tl_result    excv = TL_SUCCESS;
+    area_scaler *scaler = NULL;
+    raw_frame    src = {.data = NULL, .flength = tf->src_ln, .fwidth = tf->src_wdth};
+    raw_frame    dst = {.data = NULL, .flength = 0, .fwidth = 0};
+    char         what[128];
+    TRY(excv, create_area_scaler(tf->src_wdth, tf->src_ln, tf->wdth, tf->ln, &scaler),
+        goto epilogue);
+    src.data = malloc(tf->src_wdth * tf->src_ln);
+    dst.data = malloc(tf->wdth * tf->ln);
+    CHECK(excv, src.data == NULL || dst.data == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    for (size_t y = 0; y < tf->src_ln; ++y) {
+        for (size_t x = 0; x < tf->src_wdth; ++x) {
+            src.data[y * tf->src_wdth + x] = tf->px(x, y);
+        }
+    }
+    TRY(excv, area_scale(scaler, &src, &dst), goto epilogue);
+    *hash_out = hash_pixels(&dst);
+    if (!printing) {
+        snprintf(
+            what, sizeof(what), "scaled hash %016llx, golden %016llx",
+            (unsigned long long)*hash_out, (unsigned long long)golden_scaled[tf - frames]
+        );
+        checks++;
+        if (*hash_out != golden_scaled[tf - frames]) {
+            failures++;
+            fprintf(stderr, "FAIL %s: %s\n", tf->name, what);
+        }
+    }
+epilogue:
+    destroy_area_scaler(&scaler);
+    free(src.data);
+    free(dst.data);
+    return excv;
+}
+
+/// @brief Every check on one frame, in one mode.
+static tl_result test_mode(
+    const test_frame *tf,
+    test_render      *tr,
+    test_render      *pooled,
+    task_pool        *pool,
+    const dither_mode dmode,
+    uint64_t         *hash_out
+) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t cells = cell_count(tf);
+    char         what[128];
+
+    // On its own, against the golden hash.
+    tr->dmode = dmode;
+    tr->ctx->stable = false;
+    tr->ctx->prev_masks = NULL;
+    fill_frame(tf, false, tr);
+    TRY(excv, render(tr), return excv);
+    const uint64_t hash = hash_cells(tr->masks, cells);
+    *hash_out = hash;
+    if (mode_exact(dmode) && !printing) {
+        snprintf(
+            what, sizeof(what), "hash %016llx, golden %016llx", (unsigned long long)hash,
+            (unsigned long long)golden_hashes[tf - frames][dmode]
+        );
+        check(hash == golden_hashes[tf - frames][dmode], tf, dmode, what);
+    } else if (!mode_exact(dmode)) {
+        const double error = tone_error(tr);
+        snprintf(what, sizeof(what), "tone error %.2f over %.2f", error, BLUE_TONE_TOL);
+        check(error <= BLUE_TONE_TOL, tf, dmode, what);
+    }
+    if (dither_diffuses(dmode)) {
+        uint8_t *ref = malloc(cells);
+        CHECK(excv, ref == NULL, TL_ALLOC_FAILURE, return excv);
+        excv = ref_diffuse(tr, &kernels[dmode], ref);
+        check(excv == TL_SUCCESS && memcmp(ref, tr->masks, cells) == 0, tf, dmode,
+              "differs from the reference diffuser");
+        free(ref);
+        TRY(excv, excv, return excv);
+    }
+
+    // Within a pool task, where frames get split.
+    pooled->dmode = dmode;
+    pooled->ctx->stable = false;
+    pooled->ctx->prev_masks = NULL;
+    set_atomic_bool(&pooled->done, false);
+    pool_submit(pool, &pooled->task);
+    while (!get_atomic_bool(&pooled->done)) {
+        YieldProcessor();
+    }
+    TRY(excv, pooled->excv, return excv);
+    check(hash_cells(pooled->masks, cells) == hash, tf, dmode, "split over the pool differs");
+    if (!dither_reusable(dmode, true)) {
+        return excv;
+    }
+
+    // A block at a time.
+    tr->ctx->stable = true;
+    TRY(excv, render(tr), return excv);
+    uint8_t *held = malloc(cells);
+    uint8_t *noisy = malloc(cells);
+    CHECK(excv, held == NULL || noisy == NULL, TL_ALLOC_FAILURE, goto epilogue);
+    memcpy(held, tr->masks, cells);
+    TRY(excv, render_blocks(tr), goto epilogue);
+    check(memcmp(tr->masks, held, cells) == 0, tf, dmode, "block by block differs");
+
+    // Stable dots.
+    tr->ctx->prev_masks = held;
+    TRY(excv, render(tr), goto epilogue);
+    check(memcmp(tr->masks, held, cells) == 0, tf, dmode, "held dots moved without change");
+    fill_frame(tf, true, tr);
+    tr->ctx->prev_masks = NULL;
+    TRY(excv, render(tr), goto epilogue);
+    memcpy(noisy, tr->masks, cells);
+    tr->ctx->prev_masks = held;
+    TRY(excv, render(tr), goto epilogue);
+    const size_t loose = flipped_dots(noisy, held, cells);
+    const size_t kept = flipped_dots(tr->masks, held, cells);
+    snprintf(what, sizeof(what), "noise flips %zu held dots, %zu loose", kept, loose);
+    check(mode_holds(dmode) && loose > 0 ? kept < loose : kept <= loose, tf, dmode, what);
+epilogue:
+    tr->ctx->prev_masks = NULL;
+    free(held);
+    free(noisy);
+    return excv;
+}
+
+static tl_result create_test_render(
+    const test_frame *tf,
+    const uint8_t    *blue_tile,
+    task_pool        *pool,
+    test_render      *tr
+) {
+    tl_result    excv = TL_SUCCESS;
+    const size_t px = tf->wdth * tf->ln;
+    TRY(excv, create_dither_ctx(blue_tile, pool, &tr->ctx), return excv);
+    tr->frame = calloc(1, sizeof(raw_frame));
+    CHECK(excv, tr->frame == NULL, TL_ALLOC_FAILURE, return excv);
+    tr->frame->data = malloc(px);
+    tr->frame->fwidth = tf->wdth;
+    tr->frame->flength = tf->ln;
+    tr->frame->tiled = true;
+    tr->luma = malloc(px);
+    tr->masks = malloc(cell_count(tf));
+    CHECK(
+        excv, tr->frame->data == NULL || tr->luma == NULL || tr->masks == NULL, TL_ALLOC_FAILURE,
+        return excv
+    );
+    tr->task.fn = render_task;
+    tr->task.arg = tr;
+    set_atomic_bool(&tr->done, false);
+    return excv;
+}
+
+static void destroy_test_render(test_render *tr) {
+    destroy_dither_ctx(&tr->ctx);
+    if (tr->frame != NULL) {
+        free(tr->frame->data);
+    }
+    free(tr->frame);
+    free(tr->luma);
+    free(tr->masks);
+}
+
+int main(
+    int   argc,
+    char *argv[]
+) {
+    tl_result  excv = TL_SUCCESS;
+    uint64_t   hashes[TEST_FRAMES][DTH_MODES] = {0};
+    uint64_t   scaled[TEST_FRAMES] = {0};
+    uint8_t   *blue_tile = NULL;
+    task_pool *pool = NULL;
+    printing = argc > 1 && strcmp(argv[1], "--print") == 0;
+    _Static_assert(
+        sizeof(golden_hashes) / sizeof(golden_hashes[0]) == TEST_FRAMES,
+        "dither_golden.h needs a row per test frame."
+    );
+    _Static_assert(
+        sizeof(golden_scaled) / sizeof(golden_scaled[0]) == TEST_FRAMES,
+        "dither_golden.h needs a scaled hash per test frame."
+    );
+    TRY(excv, create_blue_tile(&blue_tile), goto epilogue);
+    TRY(excv, create_task_pool(TEST_WORKERS, false, &pool), goto epilogue);
+    for (size_t f = 0; f < TEST_FRAMES; ++f) {
+        test_render tr = {0};
+        test_render pooled = {0};
+        TRY(excv, test_scale(&frames[f], &scaled[f]), goto epilogue);
+        excv = create_test_render(&frames[f], blue_tile, NULL, &tr);
+        if (excv == TL_SUCCESS) {
+            excv = create_test_render(&frames[f], blue_tile, pool, &pooled);
+        }
+        if (excv == TL_SUCCESS) {
+            fill_frame(&frames[f], false, &pooled);
+        }
+        for (int m = 0; m < DTH_MODES && excv == TL_SUCCESS; ++m) {
+            if (mode_names[m] == NULL) {
+                fprintf(stderr, "FAIL mode %d has no name in dither_test.c\n", m);
+                failures++;
+                continue;
+            }
+            excv = test_mode(&frames[f], &tr, &pooled, pool, (dither_mode)m, &hashes[f][m]);
+        }
+        destroy_test_render(&tr);
+        destroy_test_render(&pooled);
+        if (excv != TL_SUCCESS) {
+            goto epilogue;
+        }
+    }
+    if (printing) {
+        printf("static const uint64_t golden_hashes[][DTH_MODES] = {\n");
+        for (size_t f = 0; f < TEST_FRAMES; ++f) {
+            printf("    // %s\n    {\n", frames[f].name);
+            for (int m = 0; m < DTH_MODES; ++m) {
+                if (mode_names[m] != NULL && mode_exact((dither_mode)m)) {
+                    printf(
+                        "        [%s] = 0x%016llxULL,\n", mode_names[m],
+                        (unsigned long long)hashes[f][m]
+                    );
+                }
+            }
+            printf("    },\n");
+        }
+        printf("};\n\nstatic const uint64_t golden_scaled[] = {\n");
+        for (size_t f = 0; f < TEST_FRAMES; ++f) {
+            printf("    0x%016llxULL, // %s\n", (unsigned long long)scaled[f], frames[f].name);
+        }
+        printf("};\n");
+    } else {
+        printf("%zu checks, %zu failed\n", checks, failures);
+    }
+epilogue:
+    destroy_task_pool(&pool);
+    destroy_blue_tile(&blue_tile);
+    if (excv != TL_SUCCESS) {
+        fprintf(stderr, "FAIL %s\n", err_str(excv));
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}